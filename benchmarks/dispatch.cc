@@ -0,0 +1,55 @@
+#include "harness.hh"
+
+#include <sys/resource.h>
+#include <utility>
+
+// Runner CPU time per test as the suite grows. Every test prints a few KiB so
+// that each of them is responsible for a handful of epoll events; if an event
+// costs O(1) to dispatch, the time per test stays flat.
+
+static char const binPath[] = "/usr/bin/seq";
+
+constexpr auto SeqBuilder =
+    TestBuilder<"Seq">().with_command_line<"1", "2000">();
+
+REGISTER_TEST(SeqTest, SeqBuilder);
+
+static double cpu_seconds(rusage const& usage)
+{
+    auto seconds = [](timeval const& tv) {
+        return static_cast<double>(tv.tv_sec)
+            + static_cast<double>(tv.tv_usec) / 1e6;
+    };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+template <std::size_t... Is>
+static double runner_cpu_per_test(std::index_sequence<Is...>)
+{
+    SilencedStdout silenced;
+
+    // RUSAGE_SELF does not account for the children
+    rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    TestRunner<binPath, Repeat<Is, SeqTest>...>::run_all_tests();
+    getrusage(RUSAGE_SELF, &after);
+
+    return (cpu_seconds(after) - cpu_seconds(before)) / sizeof...(Is);
+}
+
+template <std::size_t N>
+static void bench()
+{
+    double per_test = runner_cpu_per_test(std::make_index_sequence<N>{});
+    std::cout << std::setw(5) << N << " tests: " << std::fixed
+              << std::setprecision(1) << per_test * 1e6
+              << " us of runner CPU per test\n";
+}
+
+int main(void)
+{
+    bench<64>();
+    bench<128>();
+    bench<256>();
+    bench<512>();
+}
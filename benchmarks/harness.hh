@@ -0,0 +1,40 @@
+#pragma once
+
+#include "tuncfest.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// What the benchmarks share: they run whole suites of the same test repeated,
+// and time them
+
+template <std::size_t, typename T>
+using Repeat = T;
+
+// Sends our stdout to /dev/null for as long as it lives. The report itself is
+// not what we are measuring.
+class SilencedStdout
+{
+public:
+    SilencedStdout()
+    {
+        std::cout.flush();
+        saved_stdout = dup(STDOUT_FILENO);
+        int dev_null = open("/dev/null", O_WRONLY);
+        dup2(dev_null, STDOUT_FILENO);
+        close(dev_null);
+    }
+
+    SilencedStdout(SilencedStdout const&) = delete;
+    SilencedStdout& operator=(SilencedStdout const&) = delete;
+
+    ~SilencedStdout()
+    {
+        std::cout.flush();
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+private:
+    int saved_stdout;
+};
@@ -0,0 +1,99 @@
+#include "harness.hh"
+
+#include <csignal>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <utility>
+
+// Throughput of the runner and syscalls it makes per MiB of output, built
+// twice, once per I/O backend (see TUNCFEST_IO_URING). Syscalls are counted by
+// tracing the runner with ptrace, the tests it launches are not traced.
+
+static char const binPath[] = "/usr/bin/head";
+
+// 8 MiB of output per test, read by the runner in as many chunks as the pipe
+// hands it
+constexpr auto HeavyBuilder =
+    TestBuilder<"Heavy">().with_command_line<"-c", "8388608", "/dev/zero">();
+constexpr auto LightBuilder =
+    TestBuilder<"Light">().with_command_line<"-c", "16", "/dev/zero">();
+
+REGISTER_TEST(HeavyTest, HeavyBuilder);
+REGISTER_TEST(LightTest, LightBuilder);
+
+template <typename Test, std::size_t... Is>
+static void run_suite(std::index_sequence<Is...>)
+{
+    TestRunner<binPath, Repeat<Is, Test>...>::run_all_tests();
+}
+
+// Runs the suite with our stdout silenced, in a child if traced. Returns the
+// elapsed seconds, or the number of syscalls the runner made when traced.
+template <typename Test, std::size_t N>
+static double measure(bool traced)
+{
+    SilencedStdout silenced;
+
+    double result = 0;
+    if (!traced)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run_suite<Test>(std::make_index_sequence<N>{});
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        result = std::chrono::duration<double>(elapsed).count();
+    }
+    else if (pid_t pid = fork(); pid == 0)
+    {
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        raise(SIGSTOP);
+        run_suite<Test>(std::make_index_sequence<N>{});
+        std::cout.flush();
+        _exit(0);
+    }
+    else
+    {
+        int status;
+        waitpid(pid, &status, 0);
+        ptrace(PTRACE_SETOPTIONS, pid, nullptr,
+               PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL);
+
+        // Every syscall stops twice, on entry and on exit
+        std::size_t stops = 0;
+        int signal = 0;
+        while (true)
+        {
+            ptrace(PTRACE_SYSCALL, pid, nullptr, signal);
+            if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status))
+                break;
+            signal = 0;
+            if (WSTOPSIG(status) == (SIGTRAP | 0x80))
+                ++stops;
+            else
+                signal = WSTOPSIG(status);
+        }
+        result = static_cast<double>(stops / 2);
+    }
+
+    return result;
+}
+
+int main(void)
+{
+    bool uring = Runner::io_backend == Runner::IoBackend::IoUring;
+    std::cout << (uring ? "io_uring" : "epoll") << " backend\n";
+
+    constexpr std::size_t LIGHT = 512;
+    double light = measure<LightTest, LIGHT>(false);
+    std::cout << "  " << LIGHT << " tests of 16 B:   "
+              << static_cast<long>(LIGHT / light) << " tests/s, "
+              << static_cast<long>(measure<LightTest, LIGHT>(true) / LIGHT)
+              << " syscalls/test\n";
+
+    constexpr std::size_t HEAVY = 64;
+    constexpr double MIB = HEAVY * 8;
+    double heavy = measure<HeavyTest, HEAVY>(false);
+    std::cout << "  " << HEAVY << " tests of 8 MiB:  "
+              << static_cast<long>(MIB / heavy) << " MiB/s, "
+              << static_cast<long>(measure<HeavyTest, HEAVY>(true) / MIB)
+              << " syscalls/MiB\n";
+}
@@ -0,0 +1,44 @@
+#include "harness.hh"
+
+#include <utility>
+
+// Launches per second of the runner as its own RSS grows. fork has to copy
+// the page tables of the parent for every test, posix_spawn does not. Built
+// twice, once per backend (see TUNCFEST_LAUNCH_WITH_FORK).
+
+static char const binPath[] = "/bin/true";
+
+constexpr auto TrueBuilder = TestBuilder<"True">();
+
+REGISTER_TEST(TrueTest, TrueBuilder);
+
+template <std::size_t... Is>
+static double launches_per_second(std::index_sequence<Is...>)
+{
+    SilencedStdout silenced;
+
+    auto start = std::chrono::steady_clock::now();
+    TestRunner<binPath, Repeat<Is, TrueTest>...>::run_all_tests();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return sizeof...(Is) / std::chrono::duration<double>(elapsed).count();
+}
+
+int main(void)
+{
+    bool spawn = Runner::launch_backend == Runner::LaunchBackend::PosixSpawn;
+    std::cout << (spawn ? "posix_spawn" : "fork") << " backend\n";
+
+    // Touched, so that it is really part of our RSS
+    std::vector<std::vector<char>> ballast;
+    std::size_t rss_mib = 0;
+    for (std::size_t step : std::array<std::size_t, 4>{ 0, 64, 192, 768 })
+    {
+        ballast.emplace_back(step << 20, 1);
+        rss_mib += step;
+
+        double rate = launches_per_second(std::make_index_sequence<256>{});
+        std::cout << "  +" << std::setw(4) << rss_mib << " MiB of RSS: "
+                  << static_cast<long>(rate) << " launches/s\n";
+    }
+}
@@ -0,0 +1,70 @@
+#include "expect.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Benchmark mode runs the suite once per warmup and once per measured run,
+// then reports the tests that got significantly slower than in the baseline
+// it saved before as a Regression. Those it does not know cannot be.
+
+static char const binPath[] = "/bin/sh";
+
+// Sleeps for as long as benchmark_delay.txt says, counting its runs
+constexpr auto Slowed =
+    TestBuilder<"slowed">()
+        .with_command_line<"-c", "echo >> benchmark_runs.txt; "
+                                 "sleep $(cat benchmark_delay.txt)">();
+
+constexpr auto Fresh = TestBuilder<"fresh">().with_command_line<"-c", ":">();
+
+REGISTER_TEST(SlowedTest, Slowed);
+REGISTER_TEST(FreshTest, Fresh);
+
+static void set_delay(char const* seconds)
+{
+    std::ofstream("benchmark_delay.txt") << seconds;
+    std::remove("benchmark_runs.txt");
+}
+
+static std::size_t runs()
+{
+    std::ifstream in("benchmark_runs.txt");
+    std::size_t lines = 0;
+    for (std::string line; std::getline(in, line);)
+        ++lines;
+    return lines;
+}
+
+int main(void)
+{
+    char const* baseline = "benchmark_test.bench";
+    RunnerOptions options = quiet_options();
+    options.benchmark_runs = 6;
+    options.benchmark_warmups = 2;
+
+    set_delay("0.01");
+    options.benchmark_save = baseline;
+    bool ok = expect_verdicts(
+        TestRunner<binPath, SlowedTest>::run_all_tests(options),
+        { { "slowed", Verdict::Pass } });
+    ok &= expect(runs() == 8, "the warmups were not run before the others");
+
+    std::string saved;
+    std::getline(std::ifstream(baseline), saved);
+    ok &= expect(saved.starts_with("6 ") && saved.ends_with(" slowed"),
+                 "the baseline was not saved");
+
+    set_delay("0.1");
+    options.benchmark_save = nullptr;
+    options.benchmark_baseline = baseline;
+    ok &= expect_verdicts(
+        TestRunner<binPath, SlowedTest, FreshTest>::run_all_tests(options),
+        { { "slowed", Verdict::Regression }, { "fresh", Verdict::Pass } });
+    ok &= expect(runs() == 8, "the warmups were not run before the others");
+
+    std::remove(baseline);
+    std::remove("benchmark_delay.txt");
+    std::remove("benchmark_runs.txt");
+    return ok ? 0 : 1;
+}
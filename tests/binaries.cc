@@ -0,0 +1,55 @@
+#include "expect.hh"
+
+// Tests naming their own binary with with_binary run on it, next to those
+// of the runner's binary and in the same job slots, matrices included.
+// Every binary answers in its own way, so any mixup fails a test.
+
+static char const binPath[] = "/bin/cat";
+
+constexpr auto Cat = TestBuilder<"cat">()
+                         .with_stdinput<"meow">()
+                         .with_stdout_match<"meow">();
+
+constexpr auto Echo = TestBuilder<"echo">()
+                          .with_binary<"/bin/echo">()
+                          .with_stdinput<"meow">()
+                          .with_command_line<"woof">()
+                          .with_stdout_match<"woof\n">();
+
+constexpr auto Shell = TestBuilder<"sh">()
+                           .with_binary<"/bin/sh">()
+                           .with_command_line<"-c", "exit 4">()
+                           .with_stdout_match<"">()
+                           .with_exit_code_match<4>();
+
+// Their arguments come after the "woof" of the base
+constexpr std::array words = {
+    MatrixCase{ .name = "one", .args = { "1" }, .expected_stdout = "woof 1\n" },
+    MatrixCase{ .name = "two", .args = { "2" }, .expected_stdout = "woof 2\n" },
+    MatrixCase{ .name = "three",
+                .args = { "3" },
+                .expected_stdout = "woof 3\n" },
+};
+
+REGISTER_TEST(CatTest, Cat);
+REGISTER_TEST(EchoTest, Echo);
+REGISTER_TEST(ShellTest, Shell);
+REGISTER_TEST_MATRIX(Echoes, TestMatrix<Echo.with_name<"echoes">(), words>);
+
+int main(void)
+{
+    RunnerOptions options = quiet_options();
+    options.max_in_flight = 2;
+
+    bool ok = true;
+    // Over and over, for the binaries to share the slots in every order
+    for (int round = 0; round < 10; ++round)
+        ok &= expect_verdicts(TestRunner<binPath>::run_all_tests(options),
+                              { { "cat", Verdict::Pass },
+                                { "echo", Verdict::Pass },
+                                { "sh", Verdict::Pass },
+                                { "echoes/one", Verdict::Pass },
+                                { "echoes/two", Verdict::Pass },
+                                { "echoes/three", Verdict::Pass } });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#include "expect.hh"
+
+#include <vector>
+
+// The peak RSS of a test includes the one of the runner. Under it, a budget
+// above the runner's peak is known to be met, and one below it cannot be
+// checked at all.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr auto Roomy = TestBuilder<"roomy">()
+                           .with_command_line<"-c", "exit 0">()
+                           .with_max_rss<(1ull << 30)>();
+
+constexpr auto Tight = TestBuilder<"tight">()
+                           .with_command_line<"-c", "exit 0">()
+                           .with_max_rss<(1 << 20)>();
+
+// Not even measured, its results are all that count
+constexpr auto Failing = TestBuilder<"failing">()
+                             .with_command_line<"-c", "exit 1">()
+                             .with_exit_code_match<0>()
+                             .with_max_rss<(1 << 20)>();
+
+REGISTER_TEST(RoomyTest, Roomy);
+REGISTER_TEST(TightTest, Tight);
+REGISTER_TEST(FailingTest, Failing);
+
+int main(void)
+{
+    // Well over the budget of the tight test, in every page
+    std::vector<char> ballast(64 << 20, 1);
+
+    auto reports = TestRunner<binPath, RoomyTest, TightTest,
+                              FailingTest>::run_all_tests(quiet_options());
+    bool ok = expect_verdicts(reports,
+                              { { "roomy", Verdict::Pass },
+                                { "tight", Verdict::Error },
+                                { "failing", Verdict::Fail } });
+    ok &= expect(ballast.back() == 1, "the ballast went away");
+    return ok ? 0 : 1;
+}
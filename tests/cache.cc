@@ -0,0 +1,100 @@
+#include "expect.hh"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// Tests that passed are not run again until their binary, definition or
+// files change, or the testsuite is rebuilt, and those that failed always
+// are.
+
+static char const binPath[] = "/bin/cat";
+
+static bool not_empty(std::string_view out)
+{
+    return !out.empty();
+}
+
+constexpr auto FromFile = TestBuilder<"from_file">()
+                              .with_stdin_file<"cache_input.txt">()
+                              .with_stdout_validation<not_empty>();
+
+constexpr auto Failing = TestBuilder<"failing">()
+                             .with_stdinput<"42">()
+                             .with_stdout_match<"43">();
+
+REGISTER_TEST(FromFileTest, FromFile);
+REGISTER_TEST(FailingTest, Failing);
+
+using Suite = TestRunner<binPath, FromFileTest, FailingTest>;
+
+static void write_input(char const* contents)
+{
+    std::ofstream("cache_input.txt") << contents;
+}
+
+// Another build of this testsuite, which only differs by a byte at the end
+// of its executable
+static bool rebuild(char const* path)
+{
+    {
+        std::ofstream copy(path, std::ios::binary | std::ios::trunc);
+        copy << std::ifstream("/proc/self/exe", std::ios::binary).rdbuf()
+             << '\0';
+        if (!copy)
+            return false;
+    }
+    return chmod(path, 0755) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    char const* cache = "cache_test.cache";
+    RunnerOptions options = quiet_options();
+    options.result_cache = cache;
+
+    // Run by the rebuilt testsuite, on the cache left by this one
+    if (argc > 1 && argv[1] == std::string_view("rebuilt"))
+        return expect_verdicts(Suite::run_all_tests(options),
+                               { { "from_file", Verdict::Pass },
+                                 { "failing", Verdict::Fail } })
+                   ? 0
+                   : 1;
+
+    std::remove(cache);
+    write_input("first");
+
+    bool ok = expect_verdicts(Suite::run_all_tests(options),
+                              { { "from_file", Verdict::Pass },
+                                { "failing", Verdict::Fail } });
+    ok &= expect_verdicts(Suite::run_all_tests(options),
+                          { { "from_file", Verdict::Cached },
+                            { "failing", Verdict::Fail } });
+
+    // Another input is another test
+    write_input("second");
+    ok &= expect_verdicts(Suite::run_all_tests(options),
+                          { { "from_file", Verdict::Pass },
+                            { "failing", Verdict::Fail } });
+    ok &= expect_verdicts(Suite::run_all_tests(options),
+                          { { "from_file", Verdict::Cached },
+                            { "failing", Verdict::Fail } });
+
+    // Nothing tells the validators of the two builds apart
+    ok &= expect(rebuild("cache_rebuilt"),
+                 "the testsuite could not be copied");
+    ok &= expect(std::system("./cache_rebuilt rebuilt") == 0,
+                 "a rebuilt testsuite trusted the cache of the previous one");
+    std::remove("cache_rebuilt");
+
+    // Without the file, the test cannot even be keyed
+    std::remove("cache_input.txt");
+    ok &= expect_verdicts(Suite::run_all_tests(options),
+                          { { "from_file", Verdict::Error },
+                            { "failing", Verdict::Fail } });
+
+    std::remove(cache);
+    return ok ? 0 : 1;
+}
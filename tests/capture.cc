@@ -0,0 +1,60 @@
+#include "expect.hh"
+
+// Outputs grow past the inline buffer, the heap and onto a mapping, and are
+// validated whole. Past the capture limit, the test fails instead of being
+// validated on what was kept.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr std::size_t MIB = 1 << 20;
+
+// Every byte of it, not only its size
+static bool all_of_it(std::string_view out)
+{
+    return out.size() == 3 * MIB
+        && out.find_first_not_of('x') == std::string_view::npos;
+}
+
+constexpr auto Big =
+    TestBuilder<"big">()
+        .with_command_line<"-c", "head -c 3145728 /dev/zero | tr '\\0' x">()
+        .with_stdout_validation<all_of_it>();
+
+// Past the inline buffer, but still on the heap
+static bool five_thousand(std::string_view out)
+{
+    return out.size() == 5000;
+}
+
+constexpr auto Small = TestBuilder<"small">()
+                           .with_command_line<"-c", "head -c 5000 /dev/zero">()
+                           .with_stdout_validation<five_thousand>();
+
+constexpr auto Capped =
+    TestBuilder<"capped">()
+        .with_command_line<"-c", "head -c 3145728 /dev/zero | tr '\\0' x">()
+        .with_stdout_validation<all_of_it>()
+        .with_max_capture<4096>();
+
+// The cap is per stream, on stderr as well
+constexpr auto CappedStderr =
+    TestBuilder<"capped_stderr">()
+        .with_command_line<"-c", "head -c 8192 /dev/zero >&2">()
+        .with_max_capture<4096>();
+
+REGISTER_TEST(BigTest, Big);
+REGISTER_TEST(SmallTest, Small);
+REGISTER_TEST(CappedTest, Capped);
+REGISTER_TEST(CappedStderrTest, CappedStderr);
+
+int main(void)
+{
+    auto reports = TestRunner<binPath, BigTest, SmallTest, CappedTest,
+                              CappedStderrTest>::run_all_tests(quiet_options());
+    bool ok = expect_verdicts(reports,
+                              { { "big", Verdict::Pass },
+                                { "small", Verdict::Pass },
+                                { "capped", Verdict::Fail },
+                                { "capped_stderr", Verdict::Fail } });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "expect.hh"
+
+#include <cstdio>
+#include <cstring>
+
+// Tests of a program linked into the testsuite are forked from the zygote and
+// call its main directly. Its arguments, stdin, outputs and exit code are
+// those of a program run with execv, and its stdio buffers are flushed when
+// it returns. Tests naming their own binary still execv it.
+
+// Prints its arguments with printf, then its stdin with std::cout
+static int tool_main(int argc, char** argv)
+{
+    if (argc > 1 && std::strcmp(argv[1], "--fail") == 0)
+    {
+        std::fputs("failing", stderr);
+        return 3;
+    }
+
+    for (int i = 1; i < argc; ++i)
+        std::printf("%s%s", i > 1 ? " " : "", argv[i]);
+    std::printf("|");
+    std::cout << std::cin.rdbuf();
+    return argc - 1;
+}
+
+constexpr auto Args = TestBuilder<"args">()
+                          .with_command_line<"a", "b c">()
+                          .with_stdout_match<"a b c|">()
+                          .with_exit_code_match<2>();
+
+constexpr auto Input = TestBuilder<"input">()
+                           .with_stdinput<"from stdin">()
+                           .with_stdout_match<"|from stdin">()
+                           .with_exit_code_match<0>();
+
+constexpr auto Failing = TestBuilder<"failing">()
+                             .with_command_line<"--fail">()
+                             .with_stderr_match<"failing">()
+                             .with_exit_code_match<3>();
+
+constexpr auto Echo = TestBuilder<"echo">()
+                          .with_binary<"/bin/echo">()
+                          .with_command_line<"from", "echo">()
+                          .with_stdout_match<"from echo\n">();
+
+REGISTER_TEST(ArgsTest, Args);
+REGISTER_TEST(InputTest, Input);
+REGISTER_TEST(FailingTest, Failing);
+REGISTER_TEST(EchoTest, Echo);
+
+int main(void)
+{
+    auto reports = TestRunner<tool_main>::run_all_tests(quiet_options());
+    bool ok = expect_verdicts(reports,
+                              { { "args", Verdict::Pass },
+                                { "input", Verdict::Pass },
+                                { "failing", Verdict::Pass },
+                                { "echo", Verdict::Pass } });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#include "expect.hh"
+
+#include <set>
+
+// Tests spread over several event loops, each collecting the tests it
+// launched, are all collected and reported once.
+
+static char const binPath[] = "/bin/cat";
+
+constexpr auto Base = TestBuilder<"cat">();
+
+constexpr std::array inputs = {
+    MatrixCase{ .name = "a", .stdinput = "a", .expected_stdout = "a" },
+    MatrixCase{ .name = "b", .stdinput = "bb", .expected_stdout = "bb" },
+    MatrixCase{ .name = "c", .stdinput = "ccc", .expected_stdout = "ccc" },
+    MatrixCase{ .name = "d", .stdinput = "dddd", .expected_stdout = "dddd" },
+    MatrixCase{ .name = "e", .stdinput = "e\ne", .expected_stdout = "e\ne" },
+    MatrixCase{ .name = "f", .stdinput = "", .expected_stdout = "" },
+    MatrixCase{ .name = "g", .stdinput = "g g", .expected_stdout = "g g" },
+    MatrixCase{ .name = "h", .stdinput = "h\th", .expected_stdout = "h\th" },
+};
+// stdin is at its end after the first "-"
+constexpr std::array flags = {
+    MatrixCase{ .name = "plain" },
+    MatrixCase{ .name = "dash", .args = { "-" } },
+    MatrixCase{ .name = "unbuffered", .args = { "-u" } },
+    MatrixCase{ .name = "twice", .args = { "-", "-" } },
+    MatrixCase{ .name = "both", .args = { "-u", "-" } },
+    MatrixCase{ .name = "thrice", .args = { "-", "-", "-" } },
+};
+
+REGISTER_TEST_MATRIX(Cats, TestMatrix<Base, inputs, flags>);
+
+int main(void)
+{
+    Expected expected;
+    for (auto const& test : Cats::tests)
+        expected[test.test_name] = Verdict::Pass;
+
+    bool ok = true;
+    for (std::size_t loops : { 2uz, 4uz })
+    {
+        RunnerOptions options = quiet_options();
+        options.max_in_flight = 8;
+        options.event_loops = loops;
+        auto reports = TestRunner<binPath>::run_all_tests(options);
+        std::set<std::string_view> names;
+        for (auto const& report : reports)
+            names.insert(report.test_name);
+        if (!expect_verdicts(reports, expected)
+            || !expect(names.size() == reports.size(),
+                       "a test was reported twice"))
+        {
+            std::cerr << "with " << loops << " event loops\n";
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "tuncfest.hh"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+// The runner testing itself: every test program runs small suites quietly,
+// then checks what they reported. They exit with 1 when something is off,
+// after saying what on stderr.
+
+using Expected = std::map<std::string_view, Verdict>;
+
+static inline bool expect_verdicts(std::vector<TestReport> const& reports,
+                                   Expected const& expected)
+{
+    bool ok = reports.size() == expected.size();
+    if (!ok)
+        std::cerr << "got " << reports.size() << " reports for "
+                  << expected.size() << " tests\n";
+
+    for (auto const& report : reports)
+    {
+        auto found = expected.find(report.test_name);
+        if (found == expected.end())
+        {
+            std::cerr << "unexpected test " << report.test_name << '\n';
+            ok = false;
+        }
+        else if (found->second != report.verdict)
+        {
+            std::cerr << report.test_name << ": expected "
+                      << Runner::verdict_name(found->second) << ", got "
+                      << Runner::verdict_name(report.verdict) << '\n';
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static inline bool expect(bool condition, std::string_view what)
+{
+    if (!condition)
+        std::cerr << what << '\n';
+    return condition;
+}
+
+// Whether the process whose pid a test wrote to `path` is dead, given a
+// moment to go. A zombie is as good as dead, whoever inherited it may not be
+// in a hurry to reap it.
+static inline bool process_gone(char const* path)
+{
+    pid_t pid = 0;
+    if (!(std::ifstream(path) >> pid) || pid <= 0)
+        return expect(false, "no pid was left in the file");
+
+    std::string stat = "/proc/" + std::to_string(pid) + "/stat";
+    for (int tries = 0; tries < 100; ++tries)
+    {
+        std::string line;
+        if (!std::getline(std::ifstream(stat), line))
+            return true;
+        // The state comes after the command, which is in parentheses
+        auto end = line.rfind(')');
+        if (end != std::string::npos && end + 2 < line.size()
+            && line[end + 2] == 'Z')
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+// Nothing on stdout, so that ctest only shows what went wrong
+static inline RunnerOptions quiet_options()
+{
+    return { .max_in_flight = 4, .validation_threads = 2, .quiet = true };
+}
@@ -0,0 +1,56 @@
+#include "expect.hh"
+
+#include <cstdio>
+#include <fstream>
+
+// Golden files are mapped for the tests running, shared by those running at
+// the same time, and opened again by the next run of the suite.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr auto Late = TestBuilder<"late">()
+                          .with_command_line<"-c", "echo hello">()
+                          .with_stdout_file_match<"golden_late.txt">();
+
+// Several megabytes, compared by both at the same time
+constexpr auto First =
+    TestBuilder<"first">()
+        .with_command_line<"-c", "cat golden_big.txt">()
+        .with_stdout_file_match<"golden_big.txt">();
+
+constexpr auto Second =
+    TestBuilder<"second">()
+        .with_command_line<"-c", "cat golden_big.txt >&2">()
+        .with_stderr_file_match<"golden_big.txt">();
+
+REGISTER_TEST(LateTest, Late);
+REGISTER_TEST(FirstTest, First);
+REGISTER_TEST(SecondTest, Second);
+
+using Suite = TestRunner<binPath, LateTest, FirstTest, SecondTest>;
+
+int main(void)
+{
+    std::remove("golden_late.txt");
+    {
+        std::ofstream big("golden_big.txt");
+        for (int line = 0; line < 200000; ++line)
+            big << "line " << line << '\n';
+    }
+
+    bool ok = expect_verdicts(Suite::run_all_tests(quiet_options()),
+                              { { "late", Verdict::Fail },
+                                { "first", Verdict::Pass },
+                                { "second", Verdict::Pass } });
+
+    // Not remembered as missing
+    std::ofstream("golden_late.txt") << "hello\n";
+    ok &= expect_verdicts(Suite::run_all_tests(quiet_options()),
+                          { { "late", Verdict::Pass },
+                            { "first", Verdict::Pass },
+                            { "second", Verdict::Pass } });
+
+    std::remove("golden_late.txt");
+    std::remove("golden_big.txt");
+    return ok ? 0 : 1;
+}
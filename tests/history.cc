@@ -0,0 +1,83 @@
+#include "expect.hh"
+
+#include <cstdio>
+#include <fstream>
+
+// With a history file and fewer slots than tests, the longest tests are
+// launched first, and those never timed before them all. A test cut short
+// by its timeout is not timed.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr auto Short =
+    TestBuilder<"short">()
+        .with_command_line<"-c", "echo short >> launched.txt; sleep 0.05">();
+
+constexpr auto Long =
+    TestBuilder<"long">()
+        .with_command_line<"-c", "echo long >> launched.txt; sleep 0.3">();
+
+constexpr auto Medium =
+    TestBuilder<"medium">()
+        .with_command_line<"-c", "echo medium >> launched.txt; sleep 0.15">();
+
+// Would land between the long and medium ones if it was timed
+constexpr auto Cut =
+    TestBuilder<"cut">()
+        .with_command_line<"-c", "echo cut >> launched.txt; sleep 30">()
+        .with_timeout<200>();
+
+REGISTER_TEST(ShortTest, Short);
+REGISTER_TEST(LongTest, Long);
+REGISTER_TEST(MediumTest, Medium);
+REGISTER_TEST(CutTest, Cut);
+
+using Suite = TestRunner<binPath, ShortTest, LongTest, MediumTest, CutTest>;
+
+// Names of the tests, in the order they were launched, and forgets them
+static std::vector<std::string> launch_order()
+{
+    std::vector<std::string> order;
+    std::ifstream in("launched.txt");
+    for (std::string name; in >> name;)
+        order.push_back(name);
+    std::remove("launched.txt");
+    return order;
+}
+
+int main(void)
+{
+    char const* history = "history_test.history";
+    std::remove(history);
+    std::remove("launched.txt");
+
+    RunnerOptions options = quiet_options();
+    options.max_in_flight = 1;
+    options.history_file = history;
+
+    Expected verdicts = { { "short", Verdict::Pass },
+                          { "long", Verdict::Pass },
+                          { "medium", Verdict::Pass },
+                          { "cut", Verdict::Timeout } };
+
+    bool ok = expect_verdicts(Suite::run_all_tests(options), verdicts);
+    ok &= expect(launch_order()
+                     == std::vector<std::string>{ "short", "long", "medium",
+                                                  "cut" },
+                 "the first run was not in declaration order");
+
+    std::size_t timed = 0;
+    std::ifstream in(history);
+    for (std::string line; std::getline(in, line); ++timed)
+        ok &= expect(!line.ends_with(" cut"), "the cut test was timed");
+    ok &= expect(timed == 3, "the history does not have its 3 tests");
+
+    ok &= expect_verdicts(Suite::run_all_tests(options), verdicts);
+    ok &= expect(launch_order()
+                     == std::vector<std::string>{ "cut", "long", "medium",
+                                                  "short" },
+                 "the second run was not longest first");
+
+    std::remove(history);
+    return ok ? 0 : 1;
+}
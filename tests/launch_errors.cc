@@ -0,0 +1,44 @@
+#include "expect.hh"
+
+// A test that cannot be launched is an ERROR, whatever its validators would
+// have made of the exit code of 127 and the empty outputs it is given.
+
+static char const binPath[] = "/bin/cat";
+
+constexpr auto Fine = TestBuilder<"fine">()
+                          .with_stdinput<"42">()
+                          .with_stdout_match<"42">();
+
+constexpr auto NoBinary = TestBuilder<"no_binary">()
+                              .with_binary<"does/not/exist">();
+
+constexpr auto NoStdinFile = TestBuilder<"no_stdin_file">()
+                                 .with_stdin_file<"does/not/exist.txt">();
+
+constexpr auto NoPipedStdinFile =
+    TestBuilder<"no_piped_stdin_file">()
+        .with_stdin_file<"does/not/exist.txt", StdinDelivery::Pipe>();
+
+REGISTER_TEST(FineTest, Fine);
+REGISTER_TEST(NoBinaryTest, NoBinary);
+REGISTER_TEST(NoStdinFileTest, NoStdinFile);
+REGISTER_TEST(NoPipedStdinFileTest, NoPipedStdinFile);
+
+int main(void)
+{
+    auto reports =
+        TestRunner<binPath, FineTest, NoBinaryTest, NoStdinFileTest,
+                   NoPipedStdinFileTest>::run_all_tests(quiet_options());
+
+    bool ok = expect_verdicts(reports,
+                              { { "fine", Verdict::Pass },
+                                { "no_binary", Verdict::Error },
+                                { "no_stdin_file", Verdict::Error },
+                                { "no_piped_stdin_file", Verdict::Error } });
+    for (auto const& report : reports)
+        if (report.verdict == Verdict::Error)
+            ok &= expect(report.exit_code == 127,
+                         "a test that could not be launched did not exit "
+                         "with 127");
+    return ok ? 0 : 1;
+}
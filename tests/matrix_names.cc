@@ -0,0 +1,26 @@
+#include "tuncfest.hh"
+
+// Matrices whose cases would not all have their own name, which must not
+// compile. Built once per kind of mistake by the tests, which expect the
+// build to fail on the static_assert.
+
+constexpr auto base = TestBuilder<"cat">();
+
+#if defined(DUPLICATE_NAMES)
+constexpr std::array cases = {
+    MatrixCase{ .name = "same", .stdinput = "a" },
+    MatrixCase{ .name = "same", .stdinput = "b" },
+};
+#elif defined(UNNAMED_ROW)
+constexpr std::array cases = {
+    MatrixCase{ .name = "named", .stdinput = "a" },
+    MatrixCase{ .stdinput = "b" },
+};
+#elif defined(SLASH_IN_NAME)
+constexpr std::array cases = {
+    MatrixCase{ .name = "a/b", .stdinput = "a" },
+    MatrixCase{ .name = "a", .stdinput = "b" },
+};
+#endif
+
+REGISTER_TEST_MATRIX(Rejected, TestMatrix<base, cases>);
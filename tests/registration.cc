@@ -0,0 +1,46 @@
+#include "expect.hh"
+#include "registration_shared.hh"
+
+// REGISTER_TEST and REGISTER_TEST_MATRIX from several translation units
+// (see registration_matrix.cc) all end up in the same registry, which a
+// TestRunner without tests runs in order of their names. Those of a header
+// included by several of them only once.
+
+static char const binPath[] = "/bin/cat";
+
+constexpr auto Single = TestBuilder<"single">()
+                            .with_stdinput<"one">()
+                            .with_stdout_match<"one">();
+
+constexpr auto Other = TestBuilder<"other">()
+                           .with_stdinput<"two">()
+                           .with_stdout_match<"two">();
+
+REGISTER_TEST(SingleTest, Single);
+REGISTER_TEST(OtherTest, Other);
+
+int main(void)
+{
+    auto reports = TestRunner<binPath>::run_all_tests(quiet_options());
+
+    bool ok = expect_verdicts(reports,
+                              { { "single", Verdict::Pass },
+                                { "other", Verdict::Pass },
+                                { "cat", Verdict::Pass },
+                                { "cat/empty/once", Verdict::Pass },
+                                { "cat/empty/twice", Verdict::Pass },
+                                { "cat/short/once", Verdict::Pass },
+                                { "cat/short/twice", Verdict::Pass },
+                                { "last", Verdict::Pass },
+                                { "zipped/empty/once", Verdict::Pass },
+                                { "zipped/short/twice", Verdict::Pass },
+                                { "shared", Verdict::Pass },
+                                { "headed/a", Verdict::Pass },
+                                { "headed/b", Verdict::Pass } });
+    ok &= expect(std::is_sorted(reports.begin(), reports.end(),
+                                [](auto const& lhs, auto const& rhs) {
+                                    return lhs.test_name < rhs.test_name;
+                                }),
+                 "the registered tests did not run in order");
+    return ok ? 0 : 1;
+}
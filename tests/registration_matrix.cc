@@ -0,0 +1,24 @@
+#include "registration_shared.hh"
+
+// The arrays registered by the matrices sit between single pointers in the
+// registry, where the compiler would like to align them on more than that
+
+constexpr auto First = TestBuilder<"cat">();
+constexpr auto Last = TestBuilder<"last">()
+                          .with_stdinput<"three">()
+                          .with_stdout_match<"three">();
+
+constexpr std::array inputs = {
+    MatrixCase{ .name = "empty", .stdinput = "", .expected_stdout = "" },
+    MatrixCase{ .name = "short", .stdinput = "abc", .expected_stdout = "abc" },
+};
+constexpr std::array flags = {
+    MatrixCase{ .name = "once" },
+    MatrixCase{ .name = "twice", .args = { "-", "-" } },
+};
+
+REGISTER_TEST(FirstTest, First);
+REGISTER_TEST_MATRIX(Cats, TestMatrix<First, inputs, flags>);
+REGISTER_TEST(LastTest, Last);
+REGISTER_TEST_MATRIX(Zipped, ZippedTestMatrix<First.with_name<"zipped">(),
+                                               inputs, flags>);
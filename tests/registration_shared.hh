@@ -0,0 +1,20 @@
+#pragma once
+
+#include "tuncfest.hh"
+
+// Included by both registration.cc and registration_matrix.cc, each of its
+// tests still has to run once
+
+constexpr auto Shared = TestBuilder<"shared">()
+                            .with_stdinput<"four">()
+                            .with_stdout_match<"four">();
+
+constexpr auto Headed = TestBuilder<"headed">();
+
+constexpr std::array headed_inputs = {
+    MatrixCase{ .name = "a", .stdinput = "a", .expected_stdout = "a" },
+    MatrixCase{ .name = "b", .stdinput = "b", .expected_stdout = "b" },
+};
+
+REGISTER_TEST(SharedTest, Shared);
+REGISTER_TEST_MATRIX(HeadedCats, TestMatrix<Headed, headed_inputs>);
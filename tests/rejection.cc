@@ -0,0 +1,68 @@
+#include "expect.hh"
+
+// A stream validator rejecting an output kills its test right away, instead
+// of waiting for it to finish or to time out. The test being killed for its
+// output, its exit code says nothing and is not checked.
+
+static char const binPath[] = "/bin/sh";
+
+// `yes` never ends on its own
+constexpr auto Endless = TestBuilder<"endless">()
+                             .with_command_line<"-c", "exec yes">()
+                             .with_stdout_match<"y\ny\nn\n">()
+                             .with_exit_code_match<0>()
+                             .with_timeout<30000>();
+
+constexpr auto Matching = TestBuilder<"matching">()
+                              .with_command_line<"-c", "printf 'y\\ny\\n'">()
+                              .with_stdout_match<"y\ny\n">()
+                              .with_exit_code_match<0>();
+
+// The output ends before what is expected
+constexpr auto Short = TestBuilder<"short">()
+                           .with_command_line<"-c", "printf 'y\\n'">()
+                           .with_stdout_match<"y\ny\n">();
+
+// Said so in the details, rather than as a difference at byte 0
+constexpr auto NoGolden =
+    TestBuilder<"no_golden">()
+        .with_command_line<"-c", "exec yes">()
+        .with_stdout_file_match<"does/not/exist.txt">()
+        .with_timeout<30000>();
+
+// The leader is gone by the time the output is rejected, the writer it left
+// behind has to be killed all the same
+constexpr auto Abandoned =
+    TestBuilder<"abandoned">()
+        .with_command_line<"-c",
+                           "(sleep 0.2; exec yes) & echo $! > abandoned.pid">()
+        .with_stdout_match<"n\n">()
+        .with_timeout<30000>();
+
+REGISTER_TEST(EndlessTest, Endless);
+REGISTER_TEST(MatchingTest, Matching);
+REGISTER_TEST(ShortTest, Short);
+REGISTER_TEST(NoGoldenTest, NoGolden);
+REGISTER_TEST(AbandonedTest, Abandoned);
+
+int main(void)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto reports = TestRunner<binPath, EndlessTest, MatchingTest, ShortTest,
+                              NoGoldenTest, AbandonedTest>::run_all_tests(
+        quiet_options());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    bool ok = expect_verdicts(reports,
+                              { { "endless", Verdict::Fail },
+                                { "matching", Verdict::Pass },
+                                { "short", Verdict::Fail },
+                                { "no_golden", Verdict::Fail },
+                                { "abandoned", Verdict::Fail } });
+    ok &= expect(elapsed < std::chrono::seconds(10),
+                 "the rejected tests were left running");
+    ok &= expect(process_gone("abandoned.pid"),
+                 "the child of a rejected test was left running");
+    std::remove("abandoned.pid");
+    return ok ? 0 : 1;
+}
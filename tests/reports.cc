@@ -0,0 +1,132 @@
+#include "expect.hh"
+
+#include <fstream>
+#include <sstream>
+
+// The JUnit and JSON lines reports stay well-formed whatever the tests
+// print: markup, quotes, control characters and invalid UTF-8, cut at the
+// output limit or not.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr auto Markup =
+    TestBuilder<"markup">()
+        .with_command_line<"-c",
+                           "printf '<a href=\"x\">&amp;</a>\\\\\\t\\001'">();
+
+// Stray continuation byte, truncated sequence, lone lead byte, U+FFFF, and a
+// valid one at the end that the limits below cut through
+constexpr auto Garbage =
+    TestBuilder<"garbage">()
+        .with_command_line<"-c",
+                           "printf 'a\\200b\\342\\202c\\303"
+                           "\\357\\277\\277\\342\\202\\254'">();
+
+constexpr auto Failing = TestBuilder<"failing\"<&>">()
+                             .with_command_line<"-c", "printf '\\377' >&2">()
+                             .with_stderr_match<"nope">();
+
+REGISTER_TEST(MarkupTest, Markup);
+REGISTER_TEST(GarbageTest, Garbage);
+REGISTER_TEST(FailingTest, Failing);
+
+static std::string read_file(char const* path)
+{
+    std::ostringstream contents;
+    contents << std::ifstream(path).rdbuf();
+    return contents.str();
+}
+
+static bool valid_utf8(std::string_view text)
+{
+    for (std::size_t i = 0; i < text.size();)
+    {
+        std::size_t length = Runner::utf8_length(text.substr(i));
+        if (length == 0)
+            return false;
+        i += length;
+    }
+    return true;
+}
+
+static std::size_t count(std::string_view text, std::string_view what)
+{
+    std::size_t found = 0;
+    for (auto at = text.find(what); at != std::string_view::npos;
+         at = text.find(what, at + what.size()))
+        ++found;
+    return found;
+}
+
+// Not a parser, but what the escaping could get wrong: the text is valid
+// UTF-8, holds no raw control character, and the markup is balanced
+static bool check_junit(std::string_view xml)
+{
+    bool ok = expect(valid_utf8(xml), "the JUnit report is not UTF-8");
+    for (char c : xml)
+        if (static_cast<unsigned char>(c) < 0x20 && c != '\n' && c != '\t'
+            && c != '\r')
+            ok = expect(false, "the JUnit report has a control character");
+    ok &= expect(count(xml, "<testcase ") == 3
+                     && count(xml, "</testcase>") == 3,
+                 "the JUnit report does not have its 3 testcases");
+    ok &= expect(count(xml, "<") == count(xml, ">"),
+                 "the JUnit report has unescaped markup");
+    ok &= expect(xml.find("\xEF\xBF\xBF") == std::string_view::npos,
+                 "the JUnit report has a U+FFFF");
+    return ok;
+}
+
+// One object per line, with no raw control character or invalid UTF-8 in
+// any of them
+static bool check_json_lines(std::string_view jsonl)
+{
+    bool ok = expect(valid_utf8(jsonl), "the JSON lines report is not UTF-8");
+    std::size_t lines = 0;
+    while (!jsonl.empty())
+    {
+        auto end = jsonl.find('\n');
+        if (end == std::string_view::npos)
+            return expect(false, "the JSON lines report is not terminated");
+        std::string_view line = jsonl.substr(0, end);
+        ok &= expect(line.starts_with("{\"name\":\"") && line.ends_with('}'),
+                     "a JSON line is not an object");
+        for (char c : line)
+            if (static_cast<unsigned char>(c) < 0x20)
+                ok = expect(false, "a JSON line has a control character");
+        jsonl.remove_prefix(end + 1);
+        ++lines;
+    }
+    return ok && expect(lines == 3, "the JSON lines report is not 3 lines");
+}
+
+int main(void)
+{
+    bool ok = true;
+    // Whole, then cut in the middle of the multibyte sequences
+    for (std::size_t limit : { 4096uz, 3uz, 4uz, 6uz, 13uz })
+    {
+        RunnerOptions options = quiet_options();
+        options.junit_report = "reports_test.xml";
+        options.json_lines_report = "reports_test.jsonl";
+        options.report_output_limit = limit;
+
+        auto reports =
+            TestRunner<binPath, MarkupTest, GarbageTest,
+                       FailingTest>::run_all_tests(options);
+        ok &= expect_verdicts(reports,
+                              { { "markup", Verdict::Pass },
+                                { "garbage", Verdict::Pass },
+                                { "failing\"<&>", Verdict::Fail } });
+
+        bool valid = check_junit(read_file("reports_test.xml"));
+        valid &= check_json_lines(read_file("reports_test.jsonl"));
+        if (!valid)
+            std::cerr << "with an output limit of " << limit << '\n';
+        ok &= valid;
+    }
+
+    std::remove("reports_test.xml");
+    std::remove("reports_test.jsonl");
+    return ok ? 0 : 1;
+}
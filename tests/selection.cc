@@ -0,0 +1,77 @@
+#include "expect.hh"
+
+#include <cstdio>
+#include <set>
+#include <unistd.h>
+
+// --filter and --shard pick the tests to run from the command line: shards
+// are disjoint and cover the whole suite, and a quiet run still prints
+// nothing.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr auto Alpha = TestBuilder<"alpha">().with_command_line<"-c", ":">();
+constexpr auto AlphaTwo =
+    TestBuilder<"alpha_two">().with_command_line<"-c", ":">();
+constexpr auto Beta = TestBuilder<"beta">().with_command_line<"-c", ":">();
+constexpr auto Gamma = TestBuilder<"gamma">().with_command_line<"-c", ":">();
+constexpr auto Delta = TestBuilder<"delta">().with_command_line<"-c", ":">();
+
+REGISTER_TEST(AlphaTest, Alpha);
+REGISTER_TEST(AlphaTwoTest, AlphaTwo);
+REGISTER_TEST(BetaTest, Beta);
+REGISTER_TEST(GammaTest, Gamma);
+REGISTER_TEST(DeltaTest, Delta);
+
+using Suite = TestRunner<binPath, AlphaTest, AlphaTwoTest, BetaTest,
+                         GammaTest, DeltaTest>;
+
+// Names of the tests run with these arguments
+static std::set<std::string> run(std::vector<char const*> args)
+{
+    args.insert(args.begin(), "selection");
+    std::set<std::string> names;
+    for (auto const& report :
+         Suite::run_all_tests(static_cast<int>(args.size()), args.data(),
+                              quiet_options()))
+        names.emplace(report.test_name);
+    return names;
+}
+
+using Names = std::set<std::string>;
+
+int main(void)
+{
+    bool ok = expect(run({ "--filter=alpha*" })
+                         == Names{ "alpha", "alpha_two" },
+                     "--filter=alpha* did not select the alphas");
+    ok &= expect(run({ "--filter", "*a", "--filter=-gamma" })
+                     == Names{ "alpha", "beta", "delta" },
+                 "an excluding filter was not applied");
+
+    Names all;
+    std::size_t total = 0;
+    for (char const* shard : { "--shard=1/3", "--shard=2/3", "--shard=3/3" })
+    {
+        Names names = run({ shard });
+        total += names.size();
+        all.insert(names.begin(), names.end());
+    }
+    ok &= expect(total == 5 && all.size() == 5,
+                 "the shards did not split the suite");
+
+    // The output of a quiet run, which has to be empty
+    std::fflush(stdout);
+    std::cout.flush();
+    FILE* captured = std::tmpfile();
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fileno(captured), STDOUT_FILENO);
+    run({ "--filter=beta", "--shard=1/2" });
+    std::cout.flush();
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    ok &= expect(lseek(fileno(captured), 0, SEEK_END) == 0,
+                 "a quiet run printed something");
+    std::fclose(captured);
+    return ok ? 0 : 1;
+}
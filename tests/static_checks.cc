@@ -0,0 +1,149 @@
+#include "tuncfest.hh"
+
+// What can be checked at compile time is, this file only has to compile.
+
+using Runner::glob_match;
+using Runner::parse_shard;
+using Runner::utf8_length;
+using TestBuilderClass::find_mismatch;
+
+// -- glob_match -- //
+static_assert(glob_match("", ""));
+static_assert(!glob_match("", "a"));
+static_assert(glob_match("*", ""));
+static_assert(glob_match("*", "anything"));
+static_assert(glob_match("parser_*", "parser_nested"));
+static_assert(!glob_match("parser_*", "lexer_parser_nested"));
+static_assert(glob_match("*_slow", "parser_slow"));
+static_assert(!glob_match("*_slow", "parser_slow_not"));
+static_assert(glob_match("a?c", "abc"));
+static_assert(!glob_match("a?c", "ac"));
+static_assert(glob_match("a*b*c", "aXXbYYbZc"));
+static_assert(!glob_match("a*b*c", "aXXbYYbZ"));
+static_assert(glob_match("**", "x"));
+
+// -- parse_shard -- //
+constexpr bool shard_is(std::string_view text, std::size_t index,
+                        std::size_t count)
+{
+    std::size_t i = 0, n = 0;
+    return parse_shard(text, i, n) && i == index && n == count;
+}
+
+constexpr bool shard_rejected(std::string_view text)
+{
+    std::size_t i = 0, n = 0;
+    return !parse_shard(text, i, n);
+}
+
+static_assert(shard_is("1/1", 1, 1));
+static_assert(shard_is("2/4", 2, 4));
+static_assert(shard_is("4/4", 4, 4));
+static_assert(shard_rejected("0/4"));
+static_assert(shard_rejected("5/4"));
+static_assert(shard_rejected("1/0"));
+static_assert(shard_rejected("2"));
+static_assert(shard_rejected("/4"));
+static_assert(shard_rejected("2/"));
+static_assert(shard_rejected("2/4x"));
+static_assert(shard_rejected("-1/4"));
+
+// -- find_mismatch -- //
+constexpr std::size_t mismatch_at(std::string_view expected,
+                                  std::string_view chunk, std::size_t offset,
+                                  bool eof = false)
+{
+    StreamCursor cursor;
+    cursor.offset = offset;
+    cursor.eof = eof;
+    return find_mismatch(expected, chunk, cursor);
+}
+
+constexpr std::size_t npos = std::string_view::npos;
+static_assert(mismatch_at("hello", "hel", 0) == npos);
+static_assert(mismatch_at("hello", "lo", 3) == npos);
+static_assert(mismatch_at("hello", "hex", 0) == 2);
+static_assert(mismatch_at("hello", "lx", 3) == 4);
+// Longer than what is expected
+static_assert(mismatch_at("hello", "lo!", 3) == 5);
+// The end of the stream has to be the end of what is expected
+static_assert(mismatch_at("hello", "", 5, true) == npos);
+static_assert(mismatch_at("hello", "", 3, true) == 3);
+
+// -- utf8_length -- //
+static_assert(utf8_length("") == 0);
+static_assert(utf8_length("a") == 1);
+static_assert(utf8_length("\xC3\xA9") == 2);
+static_assert(utf8_length("\xE2\x82\xAC") == 3);
+static_assert(utf8_length("\xF0\x9F\x98\x80") == 4);
+// Stray continuation byte, overlong, surrogate, beyond U+10FFFF
+static_assert(utf8_length("\x80") == 0);
+static_assert(utf8_length("\xC0\xAF") == 0);
+static_assert(utf8_length("\xED\xA0\x80") == 0);
+static_assert(utf8_length("\xF4\x90\x80\x80") == 0);
+// Cut short
+static_assert(utf8_length("\xE2\x82") == 0);
+static_assert(utf8_length("\xE2\x28\xA1") == 0);
+
+// -- Matrix::tests -- //
+constexpr auto base = TestBuilder<"cat">().with_command_line<"-u">();
+
+constexpr std::array inputs = {
+    MatrixCase{ .name = "empty", .stdinput = "", .expected_stdout = "" },
+    MatrixCase{ .name = "short", .stdinput = "abc", .expected_stdout = "abc" },
+};
+constexpr std::array flags = {
+    MatrixCase{ .name = "once" },
+    MatrixCase{ .name = "twice", .args = { "-", "-" } },
+};
+
+using Product = TestMatrix<base, inputs, flags>;
+using Zipped = ZippedTestMatrix<base, inputs, flags>;
+
+constexpr bool has_args(Runner::StaticProcessData const& test,
+                        std::initializer_list<std::string_view> args)
+{
+    if (test.command_line_argc != args.size())
+        return false;
+    std::size_t i = 0;
+    for (std::string_view arg : args)
+        if (test.command_line_argv[i++] != arg)
+            return false;
+    return true;
+}
+
+static_assert(Product::size == 4);
+static_assert(Product::tests[0].test_name == "cat/empty/once");
+static_assert(Product::tests[1].test_name == "cat/empty/twice");
+static_assert(Product::tests[2].test_name == "cat/short/once");
+static_assert(Product::tests[3].test_name == "cat/short/twice");
+static_assert(has_args(Product::tests[0], { "-u" }));
+static_assert(has_args(Product::tests[3], { "-u", "-", "-" }));
+static_assert(Product::tests[3].stdinput == "abc");
+static_assert(Product::tests[3].expected_stdout == "abc");
+// Every case is its own test for the result cache
+static_assert(Product::tests[0].definition_hash
+              != Product::tests[1].definition_hash);
+static_assert(Product::tests[1].definition_hash
+              != Product::tests[3].definition_hash);
+
+static_assert(Zipped::size == 2);
+static_assert(Zipped::tests[0].test_name == "cat/empty/once");
+static_assert(Zipped::tests[1].test_name == "cat/short/twice");
+static_assert(has_args(Zipped::tests[1], { "-u", "-", "-" }));
+
+// Zipped, one table with different names is enough, and a row alone in its
+// table needs none
+constexpr std::array repeated = {
+    MatrixCase{ .name = "again", .args = { "-" } },
+    MatrixCase{ .name = "again", .args = { "-" } },
+};
+constexpr std::array unnamed = { MatrixCase{ .args = { "-n" } } };
+
+using ZippedRepeat = ZippedTestMatrix<base, inputs, repeated>;
+using Unnamed = TestMatrix<base, unnamed, flags>;
+
+static_assert(ZippedRepeat::tests[0].test_name == "cat/empty/again");
+static_assert(ZippedRepeat::tests[1].test_name == "cat/short/again");
+static_assert(Unnamed::tests[0].test_name == "cat/once");
+static_assert(has_args(Unnamed::tests[1], { "-u", "-n", "-", "-" }));
@@ -0,0 +1,50 @@
+#include "expect.hh"
+
+#include <cstdio>
+#include <fstream>
+
+// Inputs much bigger than a pipe, written by the runner as the test reads
+// them, from the test's definition or spliced from a file, come out whole.
+
+static char const binPath[] = "/bin/cat";
+
+// Twice what a pipe holds by default. The definition of a test is hashed at
+// compile time, much bigger would hit the constexpr operation limit.
+constexpr std::size_t BIG = 128 << 10;
+constexpr std::array<char, BIG> big_input = []() {
+    std::array<char, BIG> input{};
+    for (std::size_t i = 0; i < BIG; ++i)
+        input[i] = i % 64 == 63 ? '\n' : static_cast<char>('a' + i % 26);
+    return input;
+}();
+
+constexpr auto Base = TestBuilder<"cat">();
+constexpr std::array inputs = {
+    MatrixCase{ .name = "big",
+                .stdinput = std::string_view(big_input.data(), BIG),
+                .expected_stdout = std::string_view(big_input.data(), BIG) },
+};
+
+constexpr auto Piped =
+    TestBuilder<"piped">()
+        .with_stdin_file<"stdin_big.txt", StdinDelivery::Pipe>()
+        .with_stdout_file_match<"stdin_big.txt">();
+
+REGISTER_TEST_MATRIX(BigInputs, TestMatrix<Base, inputs>);
+REGISTER_TEST(PipedTest, Piped);
+
+int main(void)
+{
+    {
+        std::ofstream file("stdin_big.txt");
+        for (int line = 0; line < 100000; ++line)
+            file << "line " << line << '\n';
+    }
+
+    bool ok = expect_verdicts(TestRunner<binPath>::run_all_tests(
+                                  quiet_options()),
+                              { { "cat/big", Verdict::Pass },
+                                { "piped", Verdict::Pass } });
+    std::remove("stdin_big.txt");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#include "expect.hh"
+
+// Tests outliving their timeout are killed, SIGTERM first then SIGKILL for
+// those ignoring it, without holding up the others.
+
+static char const binPath[] = "/bin/sh";
+
+constexpr auto Quick = TestBuilder<"quick">()
+                           .with_command_line<"-c", "exit 0">()
+                           .with_exit_code_match<0>();
+
+constexpr auto Sleeps = TestBuilder<"sleeps">()
+                            .with_command_line<"-c", "sleep 30">()
+                            .with_timeout<200>();
+
+constexpr auto IgnoresTerm =
+    TestBuilder<"ignores_term">()
+        .with_command_line<"-c", "trap '' TERM; while :; do sleep 1; done">()
+        .with_timeout<200>();
+
+// Exits right away, but leaves a child holding its stdout. It still has to
+// time out, and the child has to go down with the group.
+constexpr auto Orphan =
+    TestBuilder<"orphan">()
+        .with_command_line<"-c", "sleep 30 & echo $! > orphan.pid; exit 0">()
+        .with_timeout<200>();
+
+REGISTER_TEST(QuickTest, Quick);
+REGISTER_TEST(SleepsTest, Sleeps);
+REGISTER_TEST(IgnoresTermTest, IgnoresTerm);
+REGISTER_TEST(OrphanTest, Orphan);
+
+int main(void)
+{
+    RunnerOptions options = quiet_options();
+    options.kill_grace = std::chrono::milliseconds(300);
+
+    auto start = std::chrono::steady_clock::now();
+    auto reports = TestRunner<binPath, QuickTest, SleepsTest, IgnoresTermTest,
+                              OrphanTest>::run_all_tests(options);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    bool ok = expect_verdicts(reports,
+                              { { "quick", Verdict::Pass },
+                                { "sleeps", Verdict::Timeout },
+                                { "ignores_term", Verdict::Timeout },
+                                { "orphan", Verdict::Timeout } });
+    // Nowhere near the 30s they would have taken
+    ok &= expect(elapsed < std::chrono::seconds(10),
+                 "the timed out tests were not killed in time");
+    ok &= expect(process_gone("orphan.pid"),
+                 "the child of a test outlived its timeout");
+    std::remove("orphan.pid");
+    return ok ? 0 : 1;
+}
@@ -1,39 +1,65 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <charconv>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sched.h>
+#include <span>
+#include <spawn.h>
 #include <string>
 #include <string_view>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <termios.h>
+#include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <unistd.h>
+#include <utility>
+#include <vector>
+
+#ifdef TUNCFEST_IO_URING
+#    include <linux/io_uring.h>
+#    include <poll.h>
+#endif
 
 namespace VariadicTemplatedTypesCounting
 {
+    // sizeof... does it without instantiating one struct per element
     template <typename... Ts>
-    struct parameter_pack_size;
-
-    template <>
-    struct parameter_pack_size<>
-    {
-        static constexpr std::size_t value = 0;
-    };
-
-    template <typename T, typename... Ts>
-    struct parameter_pack_size<T, Ts...>
+    struct parameter_pack_size
     {
-        static constexpr std::size_t value =
-            1 + parameter_pack_size<Ts...>::value;
+        static constexpr std::size_t value = sizeof...(Ts);
     };
 } // namespace VariadicTemplatedTypesCounting
 using VariadicTemplatedTypesCounting::parameter_pack_size;
@@ -59,6 +85,23 @@ namespace TestFormValidation
             static_assert(
                 std::is_same_v<decltype(stdinput), std::string_view const&>,
                 "The test does contain a stdinput");
+            auto& stdin_file = T::stdin_file;
+            static_assert(
+                std::is_same_v<decltype(stdin_file), char const* const&>,
+                "The test does contain a stdin_file");
+        }();
+    };
+
+    template <typename T>
+    concept HasConstexprExpectedFiles = requires {
+        requires std::is_constant_evaluated();
+        []() static consteval {
+            static_assert(std::is_same_v<decltype(T::stdout_file),
+                                         char const* const>,
+                          "The test does contain a stdout_file");
+            static_assert(std::is_same_v<decltype(T::stderr_file),
+                                         char const* const>,
+                          "The test does contain a stderr_file");
         }();
     };
 
@@ -97,10 +140,43 @@ namespace TestFormValidation
         }();
     };
 
+    // Null when the test runs on the binary of its runner
+    template <typename T>
+    concept HasConstexprBinary = requires {
+        requires std::is_constant_evaluated();
+        []() static consteval {
+            static_assert(
+                std::is_same_v<decltype(T::binary), char const* const>,
+                "The test does contain a binary");
+        }();
+    };
+
+    template <typename T>
+    concept HasConstexprLimits = requires {
+        requires std::is_constant_evaluated();
+        { T::limits.max_capture } -> std::convertible_to<std::size_t>;
+        { T::limits.timeout_ms } -> std::convertible_to<std::size_t>;
+        { T::limits.max_wall_time_ms } -> std::convertible_to<std::size_t>;
+        { T::limits.max_cpu_time_ms } -> std::convertible_to<std::size_t>;
+        { T::limits.max_rss } -> std::convertible_to<std::size_t>;
+    };
+
+    // Null when the stream is only validated once complete
+    template <typename T>
+    concept HasConstexprStreamValidation = requires {
+        requires std::is_constant_evaluated();
+        requires std::is_pointer_v<
+            std::remove_cvref_t<decltype(T::stream_validate_stdout)>>;
+        requires std::is_pointer_v<
+            std::remove_cvref_t<decltype(T::stream_validate_stderr)>>;
+    };
+
     template <typename T>
     concept TestCase = HasConstexprName<T> && HasConstexprInput<T>
-        && HasConstexprStdoutValidation<T> && HasConstexprStderrValidation<T>
-        && HasConstexprExitCodeValidation<T> && HasConstexprCommandLineArgs<T>;
+        && HasConstexprExpectedFiles<T> && HasConstexprStdoutValidation<T>
+        && HasConstexprStderrValidation<T> && HasConstexprExitCodeValidation<T>
+        && HasConstexprCommandLineArgs<T> && HasConstexprBinary<T>
+        && HasConstexprLimits<T> && HasConstexprStreamValidation<T>;
 } // namespace TestFormValidation
 // Concept that verifies something adheres to the prototype of a test.
 using TestFormValidation::TestCase;
@@ -132,134 +208,676 @@ namespace HackyWrappers
     // ostringstreams are notoriously heavy, this should be substancially
     // quicker
     //
-    // FIXME:
-    //     I think the best solution since we are going to lambdas for
-    //     validation would be to map to a file if the expected output is more
-    //     than 4096, and fail the test if the output buffer for an expected
-    //     output < 4096 reaches 4096
+    // Small outputs stay inline, bigger ones grow geometrically on the heap,
+    // and past `spill_threshold` the storage is an anonymous mapping grown
+    // with mremap so we never copy megabytes around. Whatever goes beyond
+    // `limit` is dropped and the buffer is marked as truncated, so the test
+    // can fail instead of being validated on a prefix.
     struct OutputBuffer
     {
-        char data[4096];
+        static constexpr std::size_t inline_capacity = 256;
+        static constexpr std::size_t spill_threshold = 1 << 20;
+
         std::size_t size = 0;
+        std::size_t capacity = inline_capacity;
+        std::size_t limit = static_cast<std::size_t>(-1);
+        bool truncated = false;
+
+        OutputBuffer() = default;
+        OutputBuffer(OutputBuffer const&) = delete;
+        OutputBuffer& operator=(OutputBuffer const&) = delete;
+
+        OutputBuffer(OutputBuffer&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        OutputBuffer& operator=(OutputBuffer&& other) noexcept
+        {
+            if (this == &other)
+                return *this;
+
+            release();
+            size = other.size;
+            capacity = other.capacity;
+            limit = other.limit;
+            truncated = other.truncated;
+            if (other.external)
+                external = std::exchange(other.external, nullptr);
+            else
+                std::memcpy(small, other.small, other.size);
+            other.size = 0;
+            other.capacity = inline_capacity;
+            return *this;
+        }
+
+        ~OutputBuffer()
+        {
+            release();
+        }
 
         void append(char const* src, std::size_t len)
         {
-            if (size + len < sizeof(data))
+            if (truncated)
+                return;
+
+            if (len > limit - size)
+            {
+                len = limit - size;
+                truncated = true;
+            }
+            if (size + len > capacity && !grow(size + len))
+            {
+                truncated = true;
+                return;
+            }
+
+            std::memcpy(data() + size, src, len);
+            size += len;
+        }
+
+        std::string_view view() const
+        {
+            return { data(), size };
+        }
+
+    private:
+        char small[inline_capacity];
+        // Heap or mapped storage, once we outgrew `small`
+        char* external = nullptr;
+
+        char* data()
+        {
+            return external ? external : small;
+        }
+
+        char const* data() const
+        {
+            return external ? external : small;
+        }
+
+        bool mapped() const
+        {
+            return capacity > spill_threshold;
+        }
+
+        bool grow(std::size_t needed)
+        {
+            std::size_t new_capacity = capacity * 2;
+            while (new_capacity < needed)
+                new_capacity *= 2;
+
+            if (new_capacity <= spill_threshold)
+            {
+                // Still small enough for the heap
+                char* grown = static_cast<char*>(
+                    external ? std::realloc(external, new_capacity)
+                             : std::malloc(new_capacity));
+                if (!grown)
+                    return false;
+                if (!external)
+                    std::memcpy(grown, small, size);
+                external = grown;
+            }
+            else if (mapped())
+            {
+                void* grown = mremap(external, capacity, new_capacity,
+                                     MREMAP_MAYMOVE);
+                if (grown == MAP_FAILED)
+                    return false;
+                external = static_cast<char*>(grown);
+            }
+            else
+            {
+                // Spill from the heap (or inline) to an anonymous mapping
+                void* mapping = mmap(nullptr, new_capacity,
+                                     PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (mapping == MAP_FAILED)
+                    return false;
+                std::memcpy(mapping, data(), size);
+                std::free(external);
+                external = static_cast<char*>(mapping);
+            }
+
+            capacity = new_capacity;
+            return true;
+        }
+
+        void release()
+        {
+            if (mapped())
+                munmap(external, capacity);
+            else
+                std::free(external);
+            external = nullptr;
+        }
+    };
+
+    // Read-only mapping of a whole file, so that big files can be looked at
+    // without being read into memory
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(char const* path)
+        {
+            int fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+            {
+                perror(path);
+                return;
+            }
+
+            struct stat info;
+            if (fstat(fd, &info) == -1)
+            {
+                perror(path);
+                close(fd);
+                return;
+            }
+
+            // Nothing to map in an empty file
+            size = static_cast<std::size_t>(info.st_size);
+            if (size > 0)
             {
-                std::memcpy(data + size, src, len);
-                size += len;
+                void* mapping =
+                    mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    perror(path);
+                    size = 0;
+                    close(fd);
+                    return;
+                }
+                madvise(mapping, size, MADV_SEQUENTIAL);
+                data = static_cast<char const*>(mapping);
             }
+            close(fd);
+            valid = true;
+        }
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        ~MappedFile()
+        {
+            if (data)
+                munmap(const_cast<char*>(data), size);
+        }
+
+        // False when the file could not be mapped
+        explicit operator bool() const
+        {
+            return valid;
         }
 
         std::string_view view() const
         {
             return { data, size };
         }
+
+        // Done with [begin, end) for now: unmap the whole windows it covered.
+        // They stay in the page cache, but out of our RSS, which children
+        // launched from then on would otherwise count in their peak RSS.
+        void release(std::size_t begin, std::size_t end) const
+        {
+            begin -= begin % window;
+            end -= end % window;
+            if (begin < end)
+                madvise(const_cast<char*>(data) + begin, end - begin,
+                        MADV_DONTNEED);
+        }
+
+    private:
+        static constexpr std::size_t window = 1 << 20;
+
+        char const* data = nullptr;
+        std::size_t size = 0;
+        bool valid = false;
     };
 
+    // Writes the new contents next to the file, then renames them over it:
+    // whoever reads it concurrently sees either version, and an interrupted
+    // run never leaves it half written
+    static inline void replace_file(char const* path, auto&& write)
+    {
+        std::string temporary = std::string(path) + ".tmp";
+        std::ofstream out(temporary);
+        if (!out)
+        {
+            perror(temporary.c_str());
+            return;
+        }
+        write(out);
+        out.close();
+        if (!out)
+        {
+            perror(temporary.c_str());
+            std::remove(temporary.c_str());
+            return;
+        }
+        if (std::rename(temporary.c_str(), path) == -1)
+            perror(path);
+    }
+
 } // namespace HackyWrappers
 // std::string_views cannot directly be used in template instantiation
 using HackyWrappers::sv;
 // ostringstreams are heavy, this should be less so
 using HackyWrappers::OutputBuffer;
+// Golden files are compared in place
+using HackyWrappers::MappedFile;
+// Files kept from one run to the next
+using HackyWrappers::replace_file;
+
+namespace TestSettings
+{
+    // How a with_stdin_file reaches the test
+    enum class StdinDelivery
+    {
+        // The file itself is the stdin
+        Direct,
+        // Spliced into a pipe by the runner, for programs that want one
+        Pipe,
+    };
+
+    // Numeric knobs of a test. They are grouped in a single structural type
+    // so that the TestBuilder carries one template parameter for all of them.
+    struct TestLimits
+    {
+        // Bytes captured per stream. Going beyond fails the test.
+        std::size_t max_capture = 64 << 20;
+        // The test is killed after this long. 0 means the runner's default.
+        std::size_t timeout_ms = 0;
+
+        // Performance budgets, going over fails the test. 0 means none.
+        std::size_t max_wall_time_ms = 0;
+        // User + system time
+        std::size_t max_cpu_time_ms = 0;
+        // Peak RSS, in bytes
+        std::size_t max_rss = 0;
+
+        StdinDelivery stdin_delivery = StdinDelivery::Direct;
+    };
+
+    // Where a streaming validator is at in the stream it validates
+    struct StreamCursor
+    {
+        // Bytes of the stream before the current chunk
+        std::size_t offset = 0;
+        // Free for the validator to keep whatever state it needs
+        std::uint64_t state = 0;
+        // Set for the last call, made with an empty chunk once the stream hit
+        // EOF
+        bool eof = false;
+
+        // Where the stream first differs from what was expected, and on which
+        // line. Set by the validators that can tell, when rejecting a chunk.
+        std::size_t mismatch = std::string_view::npos;
+        std::size_t mismatch_line = 0;
+
+        // The output the test expects, for the validators shared by all the
+        // tests of a TestMatrix. Empty for the others.
+        std::string_view expected;
+
+        // Set by the validators rejecting the stream because they could not
+        // read the file they compare it with, rather than for its content
+        std::string_view unreadable;
+    };
+
+    // Returning false rejects the stream right away
+    using StreamValidation = bool (*)(std::string_view chunk,
+                                      StreamCursor& cursor);
+} // namespace TestSettings
+using TestSettings::TestLimits;
+using TestSettings::StdinDelivery;
+using TestSettings::StreamCursor;
+using TestSettings::StreamValidation;
 
 namespace TestBuilderClass
 {
-    // TODO Add timeout after which we kill the process
-    template <sv Name = "", sv StdInput = "",
-              bool (*StdOutValidation)(std::string_view) =
-                  [](std::string_view) -> bool { return true; },
-              bool (*StdErrValidation)(std::string_view) =
-                  [](std::string_view) -> bool { return true; },
+    inline bool accept_any_output(std::string_view)
+    {
+        return true;
+    }
+
+    // Streaming exact match: every chunk has to continue the expected output,
+    // and the stream has to end exactly where it does. Returns where the
+    // stream first differs, or npos. The previous chunks matched, so the
+    // cursor is never past the end of `expected`.
+    static constexpr std::size_t find_mismatch(std::string_view expected,
+                                               std::string_view chunk,
+                                               StreamCursor const& cursor)
+    {
+        if (cursor.eof)
+            return cursor.offset == expected.size() ? std::string_view::npos
+                                                    : cursor.offset;
+
+        // Compared with memcmp at runtime, which is vectorized by the libc,
+        // walking the bytes is only done to find the difference for the report
+        std::string_view wanted = expected.substr(cursor.offset, chunk.size());
+        if (wanted == chunk)
+            return std::string_view::npos;
+
+        auto difference = std::mismatch(wanted.begin(), wanted.end(),
+                                        chunk.begin(), chunk.end())
+                              .first;
+        return cursor.offset
+            + static_cast<std::size_t>(difference - wanted.begin());
+    }
+
+    static inline bool reject_at(StreamCursor& cursor, std::size_t offset,
+                                 std::size_t line)
+    {
+        cursor.mismatch = offset;
+        cursor.mismatch_line = line;
+        return false;
+    }
+
+    static inline bool match_chunk(std::string_view expected,
+                                   std::string_view chunk, StreamCursor& cursor)
+    {
+        std::size_t mismatch = find_mismatch(expected, chunk, cursor);
+        if (mismatch == std::string_view::npos)
+            return true;
+
+        auto line = std::count(expected.begin(),
+                               expected.begin()
+                                   + static_cast<std::ptrdiff_t>(mismatch),
+                               '\n');
+        return reject_at(cursor, mismatch, static_cast<std::size_t>(line) + 1);
+    }
+
+    template <sv Expected>
+    inline bool stream_match(std::string_view chunk, StreamCursor& cursor)
+    {
+        return match_chunk(Expected, chunk, cursor);
+    }
+
+    // Same, against the output the runner put in the cursor
+    inline bool stream_match_expected(std::string_view chunk,
+                                      StreamCursor& cursor)
+    {
+        return match_chunk(cursor.expected, chunk, cursor);
+    }
+
+    // Same, against a file the runner mapped into the cursor when launching
+    // the test, for outputs too big to be embedded in the test binary
+    inline bool stream_file_match(std::string_view chunk, StreamCursor& cursor)
+    {
+        if (!cursor.unreadable.empty())
+            return false;
+        return match_chunk(cursor.expected, chunk, cursor);
+    }
+
+    template <sv Name = "", sv StdInput = "", sv StdInFile = "",
+              bool (*StdOutValidation)(std::string_view) = accept_any_output,
+              bool (*StdErrValidation)(std::string_view) = accept_any_output,
               bool (*ExitCodeValidation)(int) = [](int) -> bool {
                   return true;
               },
-              sv... CmdLineArgs>
+              StreamValidation StdOutStreamValidation = nullptr,
+              StreamValidation StdErrStreamValidation = nullptr,
+              sv StdOutFile = "", sv StdErrFile = "", sv Binary = "",
+              TestLimits Limits = TestLimits{}, sv... CmdLineArgs>
     struct TestBuilder
     {
         // -- Tests modifiers -- //
         template <sv NewName>
         consteval auto with_name() const
         {
-            return TestBuilder<NewName, StdInput, StdOutValidation,
+            return TestBuilder<NewName, StdInput, StdInFile, StdOutValidation,
                                StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, Limits,
                                CmdLineArgs...>{};
         }
 
         template <sv NewInput>
         consteval auto with_stdinput() const
         {
-            return TestBuilder<Name, NewInput, StdOutValidation,
+            return TestBuilder<Name, NewInput, "", StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, Limits,
+                               CmdLineArgs...>{};
+        }
+
+        // The file is the stdin of the test, so the runner never reads it and
+        // tests sharing a fixture share it in the page cache. Some programs
+        // insist on a pipe, the file is then spliced into one.
+        template <sv Path, StdinDelivery Delivery = StdinDelivery::Direct>
+        consteval auto with_stdin_file() const
+        {
+            static_assert(std::string_view(Path).size() > 0,
+                          "The stdin file needs a path");
+            constexpr TestLimits NewLimits = []() static consteval {
+                TestLimits limits = Limits;
+                limits.stdin_delivery = Delivery;
+                return limits;
+            }();
+            return TestBuilder<Name, "", Path, StdOutValidation,
                                StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, NewLimits,
                                CmdLineArgs...>{};
         }
 
         template <sv... NewArgs>
         consteval auto with_command_line() const
         {
-            return TestBuilder<Name, StdInput, StdOutValidation,
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
                                StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, Limits,
                                NewArgs...>{};
         }
 
+        // Runs the test on this executable rather than on the one of its
+        // runner, so that one runner can test several programs at once
+        template <sv Path>
+        consteval auto with_binary() const
+        {
+            static_assert(std::string_view(Path).size() > 0,
+                          "The binary needs a path");
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Path, Limits,
+                               CmdLineArgs...>{};
+        }
+
+        // Output past this many bytes (per stream) fails the test
+        template <std::size_t MaxBytes>
+        consteval auto with_max_capture() const
+        {
+            constexpr TestLimits NewLimits = []() static consteval {
+                TestLimits limits = Limits;
+                limits.max_capture = MaxBytes;
+                return limits;
+            }();
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, NewLimits,
+                               CmdLineArgs...>{};
+        }
+
+        // Kill the test if it runs longer than this
+        template <std::size_t Milliseconds>
+        consteval auto with_timeout() const
+        {
+            static_assert(Milliseconds > 0, "A timeout cannot be 0ms");
+            constexpr TestLimits NewLimits = []() static consteval {
+                TestLimits limits = Limits;
+                limits.timeout_ms = Milliseconds;
+                return limits;
+            }();
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, NewLimits,
+                               CmdLineArgs...>{};
+        }
+
+        // Budgets, checked against the rusage of the test once it exited
+        template <std::size_t Milliseconds>
+        consteval auto with_max_wall_time() const
+        {
+            static_assert(Milliseconds > 0, "A budget cannot be 0ms");
+            constexpr TestLimits NewLimits = []() static consteval {
+                TestLimits limits = Limits;
+                limits.max_wall_time_ms = Milliseconds;
+                return limits;
+            }();
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, NewLimits,
+                               CmdLineArgs...>{};
+        }
+
+        template <std::size_t Milliseconds>
+        consteval auto with_max_cpu_time() const
+        {
+            static_assert(Milliseconds > 0, "A budget cannot be 0ms");
+            constexpr TestLimits NewLimits = []() static consteval {
+                TestLimits limits = Limits;
+                limits.max_cpu_time_ms = Milliseconds;
+                return limits;
+            }();
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, NewLimits,
+                               CmdLineArgs...>{};
+        }
+
+        template <std::size_t MaxBytes>
+        consteval auto with_max_rss() const
+        {
+            static_assert(MaxBytes > 0, "A budget cannot be 0 bytes");
+            constexpr TestLimits NewLimits = []() static consteval {
+                TestLimits limits = Limits;
+                limits.max_rss = MaxBytes;
+                return limits;
+            }();
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, ExitCodeValidation,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, NewLimits,
+                               CmdLineArgs...>{};
+        }
+
         // -- Validation schemes -- //
 
         //    Lambda as custom verifier
         template <bool (*NewOut)(std::string_view)>
         consteval auto with_stdout_validation() const
         {
-            return TestBuilder<Name, StdInput, NewOut, StdErrValidation,
-                               ExitCodeValidation, CmdLineArgs...>{};
+            return TestBuilder<Name, StdInput, StdInFile, NewOut,
+                               StdErrValidation, ExitCodeValidation, nullptr,
+                               StdErrStreamValidation, "", StdErrFile, Binary,
+                               Limits, CmdLineArgs...>{};
         }
 
         template <bool (*NewErr)(std::string_view)>
         consteval auto with_stderr_validation() const
         {
-            return TestBuilder<Name, StdInput, StdOutValidation, NewErr,
-                               ExitCodeValidation, CmdLineArgs...>{};
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               NewErr, ExitCodeValidation,
+                               StdOutStreamValidation, nullptr, StdOutFile, "",
+                               Binary, Limits, CmdLineArgs...>{};
         }
 
         template <bool (*NewExit)(int)>
         consteval auto with_exit_code_validation() const
         {
-            return TestBuilder<Name, StdInput, StdOutValidation,
-                               StdErrValidation, NewExit, CmdLineArgs...>{};
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               StdErrValidation, NewExit,
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, Limits,
+                               CmdLineArgs...>{};
+        }
+
+        //    Chunk-fed verifier, run as the output arrives. The test is killed
+        //    as soon as it rejects a chunk, and the output only has to be kept
+        //    around for the report.
+        template <StreamValidation NewOut>
+        consteval auto with_stdout_stream_validation() const
+        {
+            return TestBuilder<Name, StdInput, StdInFile, accept_any_output,
+                               StdErrValidation, ExitCodeValidation, NewOut,
+                               StdErrStreamValidation, "", StdErrFile, Binary,
+                               Limits, CmdLineArgs...>{};
         }
 
-        //    Exact Match
+        template <StreamValidation NewErr>
+        consteval auto with_stderr_stream_validation() const
+        {
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               accept_any_output, ExitCodeValidation,
+                               StdOutStreamValidation, NewErr, StdOutFile, "",
+                               Binary, Limits, CmdLineArgs...>{};
+        }
+
+        //    Exact Match, checked as the output streams in
 
         // TODO make it VA
         template <sv ExpectedStdout>
         consteval auto with_stdout_match() const
         {
-            return TestBuilder<Name, StdInput,
-                               [](std::string_view actual_stdout) -> bool {
-                                   return actual_stdout == ExpectedStdout;
-                               },
+            return TestBuilder<Name, StdInput, StdInFile, accept_any_output,
                                StdErrValidation, ExitCodeValidation,
-                               CmdLineArgs...>{};
+                               stream_match<ExpectedStdout>,
+                               StdErrStreamValidation, "", StdErrFile, Binary,
+                               Limits, CmdLineArgs...>{};
         }
 
         // TODO make it VA
         template <sv ExpectedStderr>
         consteval auto with_stderr_match() const
         {
-            return TestBuilder<Name, StdInput, StdOutValidation,
-                               [](std::string_view actual_stderr) -> bool {
-                                   return actual_stderr == ExpectedStderr;
-                               },
-                               ExitCodeValidation, CmdLineArgs...>{};
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               accept_any_output, ExitCodeValidation,
+                               StdOutStreamValidation,
+                               stream_match<ExpectedStderr>, StdOutFile, "",
+                               Binary, Limits, CmdLineArgs...>{};
+        }
+
+        //    Exact Match against a file, read when the tests run. The path is
+        //    relative to the working directory of the runner.
+        template <sv Path>
+        consteval auto with_stdout_file_match() const
+        {
+            return TestBuilder<Name, StdInput, StdInFile, accept_any_output,
+                               StdErrValidation, ExitCodeValidation,
+                               stream_file_match, StdErrStreamValidation,
+                               Path, StdErrFile, Binary, Limits,
+                               CmdLineArgs...>{};
+        }
+
+        template <sv Path>
+        consteval auto with_stderr_file_match() const
+        {
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
+                               accept_any_output, ExitCodeValidation,
+                               StdOutStreamValidation, stream_file_match,
+                               StdOutFile, Path, Binary, Limits,
+                               CmdLineArgs...>{};
         }
 
         // TODO make it VA
         template <int ExpectedExitCode>
         consteval auto with_exit_code_match() const
         {
-            return TestBuilder<Name, StdInput, StdOutValidation,
+            return TestBuilder<Name, StdInput, StdInFile, StdOutValidation,
                                StdErrValidation,
                                [](int actual_exit_code) -> bool {
                                    return actual_exit_code == ExpectedExitCode;
                                },
+                               StdOutStreamValidation, StdErrStreamValidation,
+                               StdOutFile, StdErrFile, Binary, Limits,
                                CmdLineArgs...>{};
         }
 
@@ -268,12 +886,30 @@ namespace TestBuilderClass
         {
             static constexpr std::string_view test_name = Name;
             static constexpr std::string_view stdinput = StdInput;
+            static constexpr char const* stdin_file =
+                std::string_view(StdInFile).empty() ? nullptr
+                                                    : StdInFile.value;
+            // Files the outputs are matched against, null when there is none
+            static constexpr char const* stdout_file =
+                std::string_view(StdOutFile).empty() ? nullptr
+                                                     : StdOutFile.value;
+            static constexpr char const* stderr_file =
+                std::string_view(StdErrFile).empty() ? nullptr
+                                                     : StdErrFile.value;
+            // Null when it is the one of the runner
+            static constexpr char const* binary =
+                std::string_view(Binary).empty() ? nullptr : Binary.value;
             static constexpr bool (*validate_stdout)(std::string_view) =
                 StdOutValidation;
             static constexpr bool (*validate_stderr)(std::string_view) =
                 StdErrValidation;
             static constexpr bool (*validate_exit_code)(int) =
                 ExitCodeValidation;
+            static constexpr StreamValidation stream_validate_stdout =
+                StdOutStreamValidation;
+            static constexpr StreamValidation stream_validate_stderr =
+                StdErrStreamValidation;
+            static constexpr TestLimits limits = Limits;
 
             static constexpr std::size_t command_line_argc =
                 sizeof...(CmdLineArgs);
@@ -282,12 +918,102 @@ namespace TestBuilderClass
         };
     };
 
-#define REGISTER_TEST(NAME, BUILDER) using NAME = decltype(BUILDER)::Result
+// Also registers the test for TestRunner<BinaryPath>, with no test listed, to
+// find it at link time, --gc-sections or not. From a header, every
+// translation unit including it registers the same test, which is only run
+// once (see registered_tests).
+#define REGISTER_TEST(NAME, BUILDER)                                           \
+    using NAME = decltype(BUILDER)::Result;                                    \
+    [[gnu::used, gnu::retain, gnu::section("tuncfest_tests")]] static          \
+        constexpr ::Runner::StaticProcessData const*                           \
+            tuncfest_registered_##NAME =                                       \
+                &::Runner::static_process_data<NAME>
 } // namespace TestBuilderClass
 using TestBuilderClass::TestBuilder;
 
 namespace Runner
 {
+    enum class Verdict
+    {
+        Pass,
+        Fail,
+        Timeout,
+        // Valid results, but over one of its performance budgets
+        OverBudget,
+        // Passed in an earlier run of the same testsuite executable, with the
+        // same binary and files, so it was not run again
+        Cached,
+        // Could not be started: missing binary or stdin file, no more
+        // descriptors... Nothing was validated. Also valid results whose RSS
+        // budget could not be checked (see check_budgets).
+        Error,
+        // Valid results, but significantly slower than in the baseline it
+        // was benchmarked against
+        Regression,
+    };
+
+    // What a test cost, measured by the runner. The CPU and memory figures
+    // come from the kernel's rusage of the child, reaped with wait4.
+    struct ResourceUsage
+    {
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point launched;
+        // Empty if the test never wrote anything
+        std::optional<Clock::time_point> first_output;
+        Clock::time_point exited;
+
+        std::chrono::microseconds user_time{ 0 };
+        std::chrono::microseconds system_time{ 0 };
+        // In KiB, as reported by the kernel
+        long max_rss = 0;
+        // Peak RSS of the process the test was started from, in KiB. The
+        // kernel counts it in the test's own up to its execv, and a fork
+        // starts with a copy of it, so a max_rss below this is not the test's.
+        long rss_floor = 0;
+        long voluntary_context_switches = 0;
+        long involuntary_context_switches = 0;
+
+        Clock::duration wall_time() const
+        {
+            return exited - launched;
+        }
+
+        std::chrono::microseconds cpu_time() const
+        {
+            return user_time + system_time;
+        }
+
+        // Whether max_rss is the test's own peak rather than an upper bound.
+        // A forked child may touch a few pages of its own before its execv.
+        bool rss_measured() const
+        {
+            constexpr long slack = 256;
+            return max_rss > rss_floor + slack;
+        }
+
+        void fill(rusage const& usage)
+        {
+            auto to_us = [](timeval const& tv) {
+                return std::chrono::seconds(tv.tv_sec)
+                    + std::chrono::microseconds(tv.tv_usec);
+            };
+            user_time = to_us(usage.ru_utime);
+            system_time = to_us(usage.ru_stime);
+            max_rss = usage.ru_maxrss;
+            voluntary_context_switches = usage.ru_nvcsw;
+            involuntary_context_switches = usage.ru_nivcsw;
+        }
+    };
+
+    // Handed back to the user by run_all_tests, one per test
+    struct TestReport
+    {
+        std::string_view test_name;
+        Verdict verdict;
+        int exit_code;
+        ResourceUsage usage;
+    };
 
     namespace Output
     {
@@ -297,333 +1023,4491 @@ namespace Runner
 #define RESET "\033[0m"
 #define BOLD "\033[1m"
 
+        // Gives std::cout back the flags and precision it had before, however
+        // the display it was made in returns
+        class SavedFormat
+        {
+        public:
+            SavedFormat()
+                : flags(std::cout.flags()), precision(std::cout.precision())
+            {}
+
+            ~SavedFormat()
+            {
+                std::cout.flags(flags);
+                std::cout.precision(precision);
+            }
+
+            SavedFormat(SavedFormat const&) = delete;
+            SavedFormat& operator=(SavedFormat const&) = delete;
+
+        private:
+            std::ios::fmtflags flags;
+            std::streamsize precision;
+        };
+
+        // 80 columns when stdout is not a terminal
         static inline int get_terminal_width()
         {
             struct winsize w;
-            ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+            if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == -1 || w.ws_col == 0)
+                return 80;
             return static_cast<int>(w.ws_col);
         }
 
-        static inline void gradient_bar(
-            std::size_t total, std::size_t left,
-            std::tuple<unsigned char, unsigned char, unsigned char> const&
-                start_color = { 227, 52, 0 },
-            std::tuple<unsigned char, unsigned char, unsigned char> const&
-                end_color = { 92, 204, 150 })
+        // Set by SIGWINCH, the width is only queried again after that
+        inline volatile std::sig_atomic_t terminal_resized = 1;
+
+        static inline void on_terminal_resize(int)
         {
-            int width = get_terminal_width();
-            int bar_width = width - 20;
-            float progress = 1.f - static_cast<float>(left) / total;
-            int filled = static_cast<int>(bar_width * progress);
+            terminal_resized = 1;
+        }
 
-            auto [r1, g1, b1] = start_color;
-            auto [r2, g2, b2] = end_color;
+        // The bar is redrawn from the event loop, so it must not cost more
+        // than the I/O it tracks: it is only drawn on a terminal, at most
+        // `redraws_per_second` times, and with a single write.
+        class ProgressBar
+        {
+        public:
+            using Color = std::tuple<unsigned char, unsigned char,
+                                     unsigned char>;
 
-            std::cout << "\r[";
-            for (int i = 0; i < bar_width; ++i)
+            explicit ProgressBar(std::size_t redraws_per_second,
+                                 Color start = { 227, 52, 0 },
+                                 Color end = { 92, 204, 150 })
+                : enabled(redraws_per_second > 0 && isatty(STDOUT_FILENO))
+                , start_color(start)
+                , end_color(end)
             {
-                double ratio = static_cast<double>(i) / bar_width;
-                int r = static_cast<int>(r1 + (r2 - r1) * ratio);
-                int g = static_cast<int>(g1 + (g2 - g1) * ratio);
-                int b = static_cast<int>(b1 + (b2 - b1) * ratio);
-                std::cout << "\033[38;2;" << r << ";" << g << ";" << b << "m"
-                          << (i < filled ? "█"
-                                         : (i < (filled * 1.15f) ? "░" : " "))
-                          << "\033[0m";
-            }
-            std::cout << "] " << std::setw(3)
-                      << static_cast<int>(progress * 100) << "%" << std::flush;
-        };
+                if (!enabled)
+                    return;
 
-        static inline void display_result(auto const& metadata,
-                                          auto const& processes, std::size_t i)
-        {
-            int status = 0;
-            waitpid(processes[i].pid, &status, 0);
-            int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                min_interval = std::chrono::duration_cast<
+                    std::chrono::steady_clock::duration>(
+                    std::chrono::seconds(1))
+                    / redraws_per_second;
 
-            auto& stdout_validation = metadata[i].stdout_validation;
-            auto actual_stdout = processes[i].stdout_buff.view();
-            auto& stderr_validation = metadata[i].stderr_validation;
-            auto actual_stderr = processes[i].stderr_buff.view();
-            auto& exit_code_validation = metadata[i].exit_code_validation;
+                struct sigaction action = {};
+                action.sa_handler = on_terminal_resize;
+                sigemptyset(&action.sa_mask);
+                action.sa_flags = SA_RESTART;
+                sigaction(SIGWINCH, &action, &previous_sigwinch);
+                terminal_resized = 1;
+            }
 
-            bool passed_exit_code = exit_code_validation(exit_code);
-            bool passed_stdout = stdout_validation(actual_stdout);
-            bool passed_stderr = stderr_validation(actual_stderr);
-            bool passed = passed_exit_code && passed_stdout && passed_stderr;
+            ProgressBar(ProgressBar const&) = delete;
+            ProgressBar& operator=(ProgressBar const&) = delete;
 
-            std::cout << BOLD << "[" << metadata[i].test_name << "] "
-                      << (passed ? GREEN "✔ PASS" : RED "✘ FAIL") << RESET
-                      << '\n';
+            ~ProgressBar()
+            {
+                if (enabled)
+                    sigaction(SIGWINCH, &previous_sigwinch, nullptr);
+            }
 
-            if (!passed)
+            // Skipped if the last redraw is too recent, or if nothing visible
+            // changed since
+            void draw(std::size_t total, std::size_t left, bool force = false)
             {
-                std::cout << YELLOW << "Details:\n" << RESET;
+                if (!enabled)
+                    return;
 
-                // Exit code
-                if (passed_exit_code)
+                auto now = std::chrono::steady_clock::now();
+                if (!force && visible && now - last_draw < min_interval)
+                    return;
+
+                if (terminal_resized)
+                {
+                    terminal_resized = 0;
+                    width = get_terminal_width();
+                    // Forces the redraw
+                    filled = -1;
+                }
+
+                int bar_width = std::max(width - 20, 0);
+                float progress =
+                    total ? 1.f - static_cast<float>(left) / total : 1.f;
+                int new_filled = static_cast<int>(bar_width * progress);
+                if (visible && new_filled == filled)
+                    return;
+                filled = new_filled;
+
+                render(bar_width, progress);
+
+                // Whatever was printed before must come out first
+                std::cout.flush();
+                std::string_view pending = line;
+                while (!pending.empty())
+                {
+                    ssize_t count =
+                        write(STDOUT_FILENO, pending.data(), pending.size());
+                    if (count == -1 && errno == EINTR)
+                        continue;
+                    if (count <= 0)
+                        break;
+                    pending.remove_prefix(static_cast<std::size_t>(count));
+                }
+
+                visible = true;
+                last_draw = now;
+            }
+
+            // Results are printed while the bar is up, they take its line
+            void clear()
+            {
+                if (!visible)
+                    return;
+                std::cout << "\r\033[2K";
+                visible = false;
+            }
+
+            // Last state of the bar, left on its own line
+            void finish(std::size_t total)
+            {
+                if (!enabled)
+                    return;
+                draw(total, 0, true);
+                std::cout << std::endl;
+                visible = false;
+            }
+
+        private:
+            void render(int bar_width, float progress)
+            {
+                auto [r1, g1, b1] = start_color;
+                auto [r2, g2, b2] = end_color;
+
+                line.clear();
+                line += "\r[";
+                char number[8];
+                auto append_number = [&](int n) {
+                    auto end = std::to_chars(number, number + sizeof(number), n)
+                                   .ptr;
+                    line.append(number, end);
+                };
+
+                for (int i = 0; i < bar_width; ++i)
+                {
+                    double ratio = static_cast<double>(i) / bar_width;
+                    line += "\033[38;2;";
+                    append_number(static_cast<int>(r1 + (r2 - r1) * ratio));
+                    line += ';';
+                    append_number(static_cast<int>(g1 + (g2 - g1) * ratio));
+                    line += ';';
+                    append_number(static_cast<int>(b1 + (b2 - b1) * ratio));
+                    line += 'm';
+                    line += i < filled ? "█"
+                                       : (i < (filled * 1.15f) ? "░" : " ");
+                    line += "\033[0m";
+                }
+
+                int percent = static_cast<int>(progress * 100);
+                line += "] ";
+                if (percent < 100)
+                    line += ' ';
+                if (percent < 10)
+                    line += ' ';
+                append_number(percent);
+                line += '%';
+            }
+
+            bool enabled;
+            Color start_color;
+            Color end_color;
+            std::chrono::steady_clock::duration min_interval{};
+            struct sigaction previous_sigwinch = {};
+
+            int width = 80;
+            // Number of full cells on screen, -1 if unknown
+            int filled = -1;
+            bool visible = false;
+            std::chrono::steady_clock::time_point last_draw;
+
+            // Reused by every redraw
+            std::string line;
+        };
+
+        // Same convention as the shells: a process killed by signal N is
+        // seen as exiting with 128 + N
+        static inline int decode_exit_code(int status)
+        {
+            if (WIFSIGNALED(status))
+                return 128 + WTERMSIG(status);
+            return WEXITSTATUS(status);
+        }
+
+        static inline void display_usage(ResourceUsage const& usage)
+        {
+            using Ms = std::chrono::duration<double, std::milli>;
+
+            SavedFormat format;
+            std::cout << std::fixed << std::setprecision(1) << "  wall "
+                      << Ms(usage.wall_time()).count() << "ms";
+            if (usage.first_output)
+                std::cout << " (first output after "
+                          << Ms(*usage.first_output - usage.launched).count()
+                          << "ms)";
+            double max_rss_mib = static_cast<double>(usage.max_rss) / 1024.;
+            std::cout << ", user " << Ms(usage.user_time).count() << "ms"
+                      << ", sys " << Ms(usage.system_time).count() << "ms"
+                      << ", max RSS " << (usage.rss_measured() ? "" : "<= ")
+                      << max_rss_mib << "MiB, "
+                      << usage.voluntary_context_switches << "/"
+                      << usage.involuntary_context_switches
+                      << " context switches\n";
+        }
+
+        // A truncated output is never valid, the validator would only see a
+        // prefix of it. Streamed outputs were already validated as a whole,
+        // what we kept of them is only there for the report.
+        static inline bool overflowed(OutputBuffer const& output,
+                                      StreamValidation streamed)
+        {
+            return output.truncated && !streamed;
+        }
+
+        // The budgets a test went over
+        struct BudgetCheck
+        {
+            bool wall_time = false;
+            bool cpu_time = false;
+            bool rss = false;
+            // The RSS could be the runner's, and it is over the budget
+            bool rss_unenforceable = false;
+
+            bool over() const
+            {
+                return wall_time || cpu_time || rss;
+            }
+        };
+
+        // CPU time and RSS come from the kernel's accounting of the child, a
+        // loaded machine does not inflate them. The wall time has no such
+        // luck, it is measured by the runner. An RSS that may be the one of
+        // the runner (see ResourceUsage::rss_floor) is only an upper bound:
+        // within the budget that is enough, over it nothing can be told.
+        static inline BudgetCheck check_budgets(TestLimits const& limits,
+                                                ResourceUsage const& usage)
+        {
+            using std::chrono::milliseconds;
+
+            BudgetCheck check;
+            check.wall_time = limits.max_wall_time_ms > 0
+                && usage.wall_time() > milliseconds(limits.max_wall_time_ms);
+            check.cpu_time = limits.max_cpu_time_ms > 0
+                && usage.cpu_time() > milliseconds(limits.max_cpu_time_ms);
+            std::size_t rss = static_cast<std::size_t>(usage.max_rss) * 1024;
+            check.rss = limits.max_rss > 0 && usage.rss_measured()
+                && rss > limits.max_rss;
+            check.rss_unenforceable = limits.max_rss > 0
+                && !usage.rss_measured() && rss > limits.max_rss;
+            return check;
+        }
+
+        static inline void display_budgets(TestLimits const& limits,
+                                           ResourceUsage const& usage,
+                                           BudgetCheck const& check)
+        {
+            using Ms = std::chrono::duration<double, std::milli>;
+
+            SavedFormat format;
+            std::cout << std::fixed << std::setprecision(1);
+
+            auto line = [](bool over, char const* what, double measured,
+                           double budget, char const* unit) {
+                std::cout << (over ? RED "  ✘ " : GREEN "  ✔ ") << what << ' '
+                          << measured << unit
+                          << (over ? " over its " : " within its ") << budget
+                          << unit << " budget\n" RESET;
+            };
+            if (limits.max_wall_time_ms > 0)
+                line(check.wall_time, "Wall time",
+                     Ms(usage.wall_time()).count(),
+                     static_cast<double>(limits.max_wall_time_ms), "ms");
+            if (limits.max_cpu_time_ms > 0)
+                line(check.cpu_time, "CPU time", Ms(usage.cpu_time()).count(),
+                     static_cast<double>(limits.max_cpu_time_ms), "ms");
+            double budget_mib = static_cast<double>(limits.max_rss) / (1 << 20);
+            if (limits.max_rss > 0 && !check.rss_unenforceable)
+                line(check.rss,
+                     usage.rss_measured() ? "Max RSS" : "Max RSS <=",
+                     static_cast<double>(usage.max_rss) / 1024., budget_mib,
+                     "MiB");
+            else if (limits.max_rss > 0)
+                std::cout << RED "  ✘ Max RSS not above the "
+                          << static_cast<double>(usage.rss_floor) / 1024.
+                          << "MiB of the launching process, cannot be "
+                             "checked against its "
+                          << budget_mib << "MiB budget\n" RESET;
+        }
+
+        // Details about one of the outputs of a failed test
+        static inline void display_output_check(
+            std::string_view label, std::string_view name, bool passed,
+            bool overflowed, bool rejected, StreamCursor const& cursor,
+            OutputBuffer const& output, std::size_t max_capture)
+        {
+            if (passed)
+            {
+                std::cout << GREEN "  ✔ " << label << " is valid\n" RESET;
+                return;
+            }
+
+            if (overflowed)
+            {
+                std::cout << RED "  ✘ " << label
+                          << " exceeded the capture limit of " << max_capture
+                          << " bytes\n" RESET;
+                return;
+            }
+
+            std::cout << RED "  ✘ " << label << " validation failed";
+            if (rejected && !cursor.unreadable.empty())
+                std::cout << ": cannot open " << cursor.unreadable
+                          << (cursor.eof ? "" : ", the test was killed");
+            else if (rejected && cursor.mismatch != std::string_view::npos)
+                std::cout << " at byte " << cursor.mismatch << " (line "
+                          << cursor.mismatch_line << ")"
+                          << (cursor.eof ? ", where the output ended"
+                                         : ", the test was killed");
+            else if (rejected && cursor.eof)
+                std::cout << " at the end of the output, after "
+                          << cursor.offset << " bytes";
+            else if (rejected)
+                std::cout << " after " << cursor.offset
+                          << " bytes, the test was killed";
+            std::cout << '\n'
+                      << YELLOW "    got " << name << ":\n"
+                      << "    --------------------\n"
+                      << output.view() << '\n'
+                      << "    --------------------\n";
+            if (output.truncated)
+                std::cout << "    (only the first " << output.size
+                          << " bytes were kept)\n";
+            std::cout << RESET;
+        }
+
+        // Prints nothing when quiet, the verdict is all that is wanted then
+        static inline Verdict display_result(auto const& metadata,
+                                             auto const& processes,
+                                             std::size_t i, bool quiet = false)
+        {
+            if (processes[i].cached)
+            {
+                if (!quiet)
+                    std::cout << BOLD << "[" << metadata[i].test_name << "] "
+                              << GREEN "✔ CACHED" << RESET << '\n'
+                              << std::string(60, '-') << "\n";
+                return Verdict::Cached;
+            }
+
+            // The reason was left in place of its stderr
+            if (processes[i].launch_failed)
+            {
+                if (!quiet)
+                    std::cout << BOLD << "[" << metadata[i].test_name << "] "
+                              << RED "✘ ERROR" << RESET << '\n'
+                              << YELLOW << "Details:\n" << RESET
+                              << RED "  ✘ Could not be launched: "
+                              << processes[i].stderr_buff.view() << RESET
+                              << std::string(60, '-') << "\n";
+                return Verdict::Error;
+            }
+
+            int status = processes[i].status;
+            int exit_code = decode_exit_code(status);
+
+            auto actual_stdout = processes[i].stdout_buff.view();
+            auto actual_stderr = processes[i].stderr_buff.view();
+
+            bool stdout_overflowed = overflowed(
+                processes[i].stdout_buff, metadata[i].stdout_stream_validation);
+            bool stderr_overflowed = overflowed(
+                processes[i].stderr_buff, metadata[i].stderr_stream_validation);
+            bool stdout_rejected = processes[i].stdout_rejected;
+            bool stderr_rejected = processes[i].stderr_rejected;
+
+            bool timed_out = processes[i].timed_out;
+
+            // The validators already ran on the pool
+            bool passed_exit_code = processes[i].passed_exit_code;
+            bool passed_stdout = processes[i].passed_stdout;
+            bool passed_stderr = processes[i].passed_stderr;
+            bool passed = !timed_out && passed_exit_code && passed_stdout
+                && passed_stderr;
+
+            // Only worth looking at once the results are right
+            BudgetCheck budgets =
+                check_budgets(metadata[i].limits, processes[i].usage);
+            bool over_budget = passed && budgets.over();
+            // Not a pass nor a failure of the test, the runner is in the way
+            bool unenforceable = passed && budgets.rss_unenforceable;
+
+            Verdict verdict = timed_out ? Verdict::Timeout
+                : unenforceable         ? Verdict::Error
+                : over_budget           ? Verdict::OverBudget
+                : passed                ? Verdict::Pass
+                                        : Verdict::Fail;
+            if (quiet)
+                return verdict;
+
+            std::cout << BOLD << "[" << metadata[i].test_name << "] "
+                      << (timed_out           ? RED "⏱ TIMEOUT"
+                              : unenforceable ? RED "✘ ERROR"
+                              : over_budget   ? RED "✘ OVER BUDGET"
+                              : passed        ? GREEN "✔ PASS"
+                                              : RED "✘ FAIL")
+                      << RESET << '\n';
+            display_usage(processes[i].usage);
+
+            if (timed_out)
+            {
+                // Validators are meaningless on a killed process, but the
+                // partial output usually tells where it got stuck
+                std::cout << YELLOW << "Details:\n" << RESET
+                          << RED "  ✘ Killed after " << processes[i].timeout_ms
+                          << "ms\n"
+                          << YELLOW "    partial stdout:\n"
+                          << "    --------------------\n"
+                          << actual_stdout << '\n'
+                          << "    --------------------\n"
+                          << "    partial stderr:\n"
+                          << "    --------------------\n"
+                          << actual_stderr << '\n'
+                          << "    --------------------\n"
+                          << RESET;
+            }
+            else if (!passed || over_budget || unenforceable)
+            {
+                std::cout << YELLOW << "Details:\n" << RESET;
+
+                // Exit code
+                if (processes[i].killed_on_rejection)
+                {
+                    std::cout << YELLOW "  - Exit code not checked, the test "
+                                        "was killed for its output\n" RESET;
+                }
+                else if (passed_exit_code)
                 {
                     std::cout << GREEN "  ✔ Exit code is valid\n" RESET;
                 }
                 else
                 {
-                    std::cout << RED "  ✘ Exit code validation failed\n"
-                              << "    got exit code: " << exit_code << '\n'
-                              << RESET;
+                    std::cout << RED "  ✘ Exit code validation failed\n";
+                    if (WIFSIGNALED(status))
+                        std::cout << "    killed by signal " << WTERMSIG(status)
+                                  << " (" << strsignal(WTERMSIG(status))
+                                  << "), seen as exit code " << exit_code
+                                  << '\n';
+                    else
+                        std::cout << "    got exit code: " << exit_code << '\n';
+                    std::cout << RESET;
+                }
+
+                display_output_check("Stdout", "stdout", passed_stdout,
+                                     stdout_overflowed, stdout_rejected,
+                                     processes[i].stdout_cursor,
+                                     processes[i].stdout_buff,
+                                     metadata[i].limits.max_capture);
+                display_output_check("Stderr", "stderr", passed_stderr,
+                                     stderr_overflowed, stderr_rejected,
+                                     processes[i].stderr_cursor,
+                                     processes[i].stderr_buff,
+                                     metadata[i].limits.max_capture);
+
+                if (over_budget || unenforceable)
+                    display_budgets(metadata[i].limits, processes[i].usage,
+                                    budgets);
+            }
+
+            std::cout << std::string(60, '-') << "\n";
+
+            return verdict;
+        }
+
+        static inline void display_summary(std::size_t num_tests,
+                                           std::size_t cached,
+                                           std::size_t slots,
+                                           std::chrono::nanoseconds wall_time)
+        {
+            SavedFormat format;
+            auto seconds = std::chrono::duration<double>(wall_time).count();
+            std::cout << BOLD << "Ran " << num_tests - cached << " tests in "
+                      << std::fixed << std::setprecision(3) << seconds
+                      << "s with " << slots << " job slots";
+            if (cached > 0)
+                std::cout << ", " << cached << " cached";
+            std::cout << RESET << '\n';
+        }
+
+        static constexpr std::string_view verdict_name(Verdict verdict)
+        {
+            switch (verdict)
+            {
+            case Verdict::Pass:
+                return "pass";
+            case Verdict::Fail:
+                return "fail";
+            case Verdict::Timeout:
+                return "timeout";
+            case Verdict::OverBudget:
+                return "over_budget";
+            case Verdict::Cached:
+                return "cached";
+            case Verdict::Error:
+                return "error";
+            case Verdict::Regression:
+                return "regression";
+            default:
+                return "unknown";
+            }
+        }
+
+        enum class ReportFormat
+        {
+            JUnit,
+            JsonLines,
+        };
+
+        // Length of the well-formed UTF-8 sequence `text` starts with, 0 if
+        // it does not start with one (stray continuation byte, overlong or
+        // surrogate encoding, sequence cut short...)
+        static constexpr std::size_t utf8_length(std::string_view text)
+        {
+            auto byte = [&](std::size_t i) {
+                return static_cast<unsigned char>(text[i]);
+            };
+            if (text.empty())
+                return 0;
+
+            unsigned char lead = byte(0);
+            if (lead < 0x80)
+                return 1;
+
+            // Allowed range of the second byte, the others are always
+            // continuation bytes
+            std::size_t length;
+            unsigned char low = 0x80, high = 0xBF;
+            if (lead >= 0xC2 && lead <= 0xDF)
+                length = 2;
+            else if (lead >= 0xE0 && lead <= 0xEF)
+            {
+                length = 3;
+                if (lead == 0xE0)
+                    low = 0xA0;
+                else if (lead == 0xED)
+                    high = 0x9F;
+            }
+            else if (lead >= 0xF0 && lead <= 0xF4)
+            {
+                length = 4;
+                if (lead == 0xF0)
+                    low = 0x90;
+                else if (lead == 0xF4)
+                    high = 0x8F;
+            }
+            else
+                return 0;
+
+            if (text.size() < length || byte(1) < low || byte(1) > high)
+                return 0;
+            for (std::size_t i = 2; i < length; ++i)
+                if ((byte(i) & 0xC0) != 0x80)
+                    return 0;
+            return length;
+        }
+
+        // Machine readable report, appended to as the tests complete. Records
+        // are formatted in an arena sized once for the worst case, and only
+        // written out when it is full, so a big suite costs a few writes.
+        class ReportSink
+        {
+        public:
+            static constexpr std::size_t max_arena = 1 << 20;
+
+            ReportSink(char const* path, ReportFormat format_,
+                       std::string_view suite, std::size_t num_tests,
+                       std::size_t max_output_)
+                : format(format_)
+                , max_output(max_output_)
+            {
+                fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                          0644);
+                if (fd == -1)
+                {
+                    perror(path);
+                    return;
+                }
+
+                // Every byte may be escaped to 6, and there are two outputs
+                record_bound = 12 * max_output + 512;
+                arena.reserve(std::min(
+                    max_arena, std::max(num_tests, std::size_t{ 1 })
+                                   * record_bound + 512));
+
+                if (format == ReportFormat::JUnit)
+                {
+                    arena += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                             "<testsuite name=\"";
+                    append_escaped(suite, 256);
+                    arena += "\" tests=\"";
+                    append_number(num_tests);
+                    arena += "\">\n";
+                }
+            }
+
+            ReportSink(ReportSink&& other) noexcept
+                : fd(std::exchange(other.fd, -1))
+                , format(other.format)
+                , max_output(other.max_output)
+                , record_bound(other.record_bound)
+                , arena(std::move(other.arena))
+            {}
+
+            ReportSink(ReportSink const&) = delete;
+            ReportSink& operator=(ReportSink const&) = delete;
+            ReportSink& operator=(ReportSink&&) = delete;
+
+            ~ReportSink()
+            {
+                if (fd == -1)
+                    return;
+                if (format == ReportFormat::JUnit)
+                    arena += "</testsuite>\n";
+                flush();
+                close(fd);
+            }
+
+            void add(TestReport const& report, OutputBuffer const& out,
+                     OutputBuffer const& err)
+            {
+                if (fd == -1)
+                    return;
+
+                // Keeps the arena from ever growing
+                std::size_t bound = record_bound + 6 * report.test_name.size();
+                if (arena.size() + bound > arena.capacity())
+                    flush();
+                if (bound > arena.capacity())
+                    arena.reserve(bound);
+
+                auto seconds = std::chrono::duration<double>(
+                                   report.usage.wall_time())
+                                   .count();
+                if (format == ReportFormat::JUnit)
+                    add_junit(report, seconds, out, err);
+                else
+                    add_json(report, seconds, out, err);
+            }
+
+        private:
+            void add_junit(TestReport const& report, double seconds,
+                           OutputBuffer const& out, OutputBuffer const& err)
+            {
+                arena += "  <testcase classname=\"tuncfest\" name=\"";
+                append_escaped(report.test_name, report.test_name.size());
+                arena += "\" time=\"";
+                append_number(seconds);
+                arena += "\">\n    <properties><property name=\"exit_code\" "
+                         "value=\"";
+                append_number(report.exit_code);
+                arena += "\"/></properties>\n";
+
+                if (report.verdict == Verdict::Timeout)
+                    arena += "    <failure type=\"timeout\" "
+                             "message=\"killed after its timeout\"/>\n";
+                else if (report.verdict == Verdict::OverBudget)
+                    arena += "    <failure type=\"budget\" "
+                             "message=\"over its performance budget\"/>\n";
+                else if (report.verdict == Verdict::Cached)
+                    arena += "    <skipped message=\"passed in an earlier "
+                             "run\"/>\n";
+                else if (report.verdict == Verdict::Error)
+                    arena += "    <error type=\"error\" message=\"could not "
+                             "be launched or measured\"/>\n";
+                else if (report.verdict == Verdict::Regression)
+                    arena += "    <failure type=\"regression\" "
+                             "message=\"slower than its baseline\"/>\n";
+                else if (report.verdict != Verdict::Pass)
+                    arena += "    <failure type=\"validation\" "
+                             "message=\"validation failed\"/>\n";
+
+                arena += "    <system-out>";
+                append_escaped(out.view(), max_output);
+                arena += "</system-out>\n    <system-err>";
+                append_escaped(err.view(), max_output);
+                arena += "</system-err>\n  </testcase>\n";
+            }
+
+            void add_json(TestReport const& report, double seconds,
+                          OutputBuffer const& out, OutputBuffer const& err)
+            {
+                arena += "{\"name\":\"";
+                append_escaped(report.test_name, report.test_name.size());
+                arena += "\",\"verdict\":\"";
+                arena += verdict_name(report.verdict);
+                arena += "\",\"exit_code\":";
+                append_number(report.exit_code);
+                arena += ",\"duration\":";
+                append_number(seconds);
+                arena += ",\"stdout\":\"";
+                append_escaped(out.view(), max_output);
+                arena += "\",\"stdout_truncated\":";
+                arena += truncated(out) ? "true" : "false";
+                arena += ",\"stderr\":\"";
+                append_escaped(err.view(), max_output);
+                arena += "\",\"stderr_truncated\":";
+                arena += truncated(err) ? "true" : "false";
+                arena += "}\n";
+            }
+
+            bool truncated(OutputBuffer const& output) const
+            {
+                return output.truncated || output.size > max_output;
+            }
+
+            void append_number(auto value)
+            {
+                char number[32];
+                std::to_chars_result result;
+                if constexpr (std::is_floating_point_v<decltype(value)>)
+                    result = std::to_chars(number, number + sizeof(number),
+                                           value, std::chars_format::fixed,
+                                           6);
+                else
+                    result =
+                        std::to_chars(number, number + sizeof(number), value);
+                arena.append(number, result.ptr);
+            }
+
+            // At most `limit` bytes of `text`, without cutting a UTF-8
+            // sequence in half. Neither format accepts invalid UTF-8, every
+            // byte that is not part of a valid sequence becomes a U+FFFD.
+            void append_escaped(std::string_view text, std::size_t limit)
+            {
+                limit = std::min(limit, text.size());
+                for (std::size_t i = 0; i < limit;)
+                {
+                    std::size_t length = utf8_length(text.substr(i));
+                    if (length == 0)
+                    {
+                        arena += "\xEF\xBF\xBD";
+                        ++i;
+                        continue;
+                    }
+                    if (i + length > limit)
+                        break;
+                    if (length > 1)
+                    {
+                        // Nor does XML accept U+FFFE and U+FFFF
+                        auto sequence = text.substr(i, length);
+                        bool non_character = format == ReportFormat::JUnit
+                            && sequence.starts_with("\xEF\xBF")
+                            && (static_cast<unsigned char>(sequence.back())
+                                & 0xFE)
+                                == 0xBE;
+                        if (non_character)
+                            arena += "\xEF\xBF\xBD";
+                        else
+                            arena += sequence;
+                        i += length;
+                        continue;
+                    }
+
+                    char c = text[i++];
+                    auto byte = static_cast<unsigned char>(c);
+                    if (format == ReportFormat::JUnit)
+                    {
+                        switch (c)
+                        {
+                        case '&':
+                            arena += "&amp;";
+                            break;
+                        case '<':
+                            arena += "&lt;";
+                            break;
+                        case '>':
+                            arena += "&gt;";
+                            break;
+                        case '"':
+                            arena += "&quot;";
+                            break;
+                        default:
+                            // Control characters cannot appear in XML 1.0,
+                            // even escaped
+                            if (byte < 0x20 && c != '\n' && c != '\t'
+                                && c != '\r')
+                                arena += "\xEF\xBF\xBD";
+                            else
+                                arena += c;
+                        }
+                    }
+                    else if (c == '"' || c == '\\')
+                    {
+                        arena += '\\';
+                        arena += c;
+                    }
+                    else if (c == '\n')
+                        arena += "\\n";
+                    else if (byte < 0x20)
+                    {
+                        constexpr char hex[] = "0123456789abcdef";
+                        arena += "\\u00";
+                        arena += hex[byte >> 4];
+                        arena += hex[byte & 0xF];
+                    }
+                    else
+                        arena += c;
+                }
+            }
+
+            void flush()
+            {
+                std::string_view pending = arena;
+                while (!pending.empty())
+                {
+                    ssize_t count = write(fd, pending.data(), pending.size());
+                    if (count == -1 && errno == EINTR)
+                        continue;
+                    if (count == -1)
+                    {
+                        perror("write");
+                        break;
+                    }
+                    pending.remove_prefix(static_cast<std::size_t>(count));
+                }
+                arena.clear();
+            }
+
+            int fd = -1;
+            ReportFormat format;
+            std::size_t max_output;
+            // Largest record, the test name aside
+            std::size_t record_bound = 0;
+            std::string arena;
+        };
+    } // namespace Output
+    using Output::decode_exit_code;
+    using Output::get_terminal_width;
+    using Output::ProgressBar;
+    using Output::overflowed;
+    using Output::display_result;
+    using Output::display_usage;
+    using Output::display_summary;
+    using Output::SavedFormat;
+    using Output::verdict_name;
+    using Output::utf8_length;
+    using Output::ReportFormat;
+    using Output::ReportSink;
+
+    // How the children are started. posix_spawn (vfork semantics in glibc)
+    // does not copy the page tables of the runner, which matters once it has
+    // a big RSS. Define TUNCFEST_LAUNCH_WITH_FORK to use fork + execv instead.
+    enum class LaunchBackend
+    {
+        Fork,
+        PosixSpawn,
+    };
+
+#ifdef TUNCFEST_LAUNCH_WITH_FORK
+    inline constexpr LaunchBackend launch_backend = LaunchBackend::Fork;
+#else
+    inline constexpr LaunchBackend launch_backend = LaunchBackend::PosixSpawn;
+#endif
+
+    // How the runner waits on its children. Define TUNCFEST_IO_URING to read
+    // their outputs through io_uring, which costs no syscall per chunk. The
+    // runner falls back to epoll when the kernel refuses to set up a ring.
+    enum class IoBackend
+    {
+        Epoll,
+        IoUring,
+    };
+
+#ifdef TUNCFEST_IO_URING
+    inline constexpr IoBackend io_backend = IoBackend::IoUring;
+#else
+    inline constexpr IoBackend io_backend = IoBackend::Epoll;
+#endif
+
+    // Knobs that can only be decided at runtime
+    struct RunnerOptions
+    {
+        // Maximum number of tests running at the same time. 0 means one per
+        // online core.
+        std::size_t max_in_flight = 0;
+
+        // Timeout of the tests that do not set their own. 0 means none.
+        std::chrono::milliseconds default_timeout{ 0 };
+        // Time between the SIGTERM and the SIGKILL of a test that timed out
+        std::chrono::milliseconds kill_grace{ 1000 };
+
+        // Threads running the validators of finished tests. 0 means one per
+        // online core.
+        std::size_t validation_threads = 0;
+        // Threads collecting the output of the tests, each with its own event
+        // loop and share of the job slots. 0 means one per online core.
+        std::size_t event_loops = 1;
+
+        // Cap on the redraws of the progress bar, 0 hides it. It is never
+        // shown when stdout is not a terminal.
+        std::size_t progress_redraws_per_second = 10;
+
+        // Machine readable reports, written as the tests complete. nullptr
+        // means no report.
+        char const* junit_report = nullptr;
+        char const* json_lines_report = nullptr;
+        // Bytes of each output kept in these reports
+        std::size_t report_output_limit = 4096;
+
+        // Only the tests whose name matches one of these globs (with * and ?)
+        // run, all of them when there is none. A leading '-' excludes the
+        // matching tests instead.
+        std::vector<std::string_view> filters{};
+        // Runs the shard_index-th (counting from 1) of shard_count slices of
+        // the selected tests, to spread a suite over several machines
+        std::size_t shard_index = 1;
+        std::size_t shard_count = 1;
+        // Print the names of the selected tests instead of running them
+        bool list_tests = false;
+
+        // Print nothing, the reports are still returned and written
+        bool quiet = false;
+
+        // Where the keys of the tests that passed are kept. Those that would
+        // run from the same testsuite executable, with the same binary and
+        // files, are not run again, and reported as Cached. Any rebuild of
+        // the testsuite runs them all again. nullptr means no cache.
+        char const* result_cache = nullptr;
+
+        // Where the durations of the tests are kept from one run to the next.
+        // With fewer slots than tests, the longest ones are launched first.
+        // nullptr means no history.
+        char const* history_file = nullptr;
+
+        // Benchmark mode, when benchmark_runs is not 0: every test runs
+        // benchmark_warmups times for nothing, then benchmark_runs times to
+        // get statistics on its wall and CPU times
+        std::size_t benchmark_runs = 0;
+        std::size_t benchmark_warmups = 1;
+        // One test at a time, for less noise
+        bool benchmark_serial = false;
+        // Core the runner, and thus its tests, are pinned to. -1 means none.
+        int benchmark_cpu = -1;
+        // Statistics of a previous run to compare with, and where to save the
+        // ones of this run. nullptr means none.
+        char const* benchmark_baseline = nullptr;
+        char const* benchmark_save = nullptr;
+    };
+
+    static inline void print_usage(std::ostream& out, char const* program)
+    {
+        out << "usage: " << program << " [options]\n"
+            << "  --filter=GLOB  only run the tests matching GLOB (* and ?), "
+               "can be repeated,\n"
+            << "                 a leading '-' excludes the matching tests\n"
+            << "  --shard=I/N    only run the I-th of N slices of the tests\n"
+            << "  --list         print the selected tests instead of running "
+               "them\n"
+            << "  --loops=N      collect the outputs on N threads (0 for one "
+               "per core)\n"
+            << "  --benchmark=K  run every test K times and print timing "
+               "statistics\n"
+            << "  --warmup=W     runs discarded before benchmarking (default "
+               "1)\n"
+            << "  --serial       benchmark one test at a time\n"
+            << "  --pin=CPU      pin the benchmark to a core\n"
+            << "  --baseline=F   compare the benchmark with the one saved in "
+               "F\n"
+            << "  --save=F       save the benchmark statistics to F\n"
+            << "  --cache=F      skip the tests that passed as they are in "
+               "the cache F\n"
+            << "  --history=F    launch the longest tests first, as timed in "
+               "F\n"
+            << "  --help         print this message\n";
+    }
+
+    // I/N with 1 <= I <= N
+    static constexpr bool parse_shard(std::string_view shard,
+                                      std::size_t& index, std::size_t& count)
+    {
+        auto slash = shard.find('/');
+        if (slash == std::string_view::npos)
+            return false;
+
+        char const* end = shard.data() + shard.size();
+        auto [index_end, index_error] =
+            std::from_chars(shard.data(), shard.data() + slash, index);
+        auto [count_end, count_error] =
+            std::from_chars(shard.data() + slash + 1, end, count);
+        return index_error == std::errc{} && count_error == std::errc{}
+            && index_end == shard.data() + slash && count_end == end
+            && index > 0 && index <= count;
+    }
+
+    // Reads the command line of the test binary into `options`. Returns false
+    // after printing the usage if it is not valid, and exits on --help.
+    static inline bool parse_arguments(int argc, char const* const* argv,
+                                       RunnerOptions& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+            if (arg.starts_with("--filter="))
+                options.filters.push_back(arg.substr(9));
+            else if (arg == "--filter" && i + 1 < argc)
+                options.filters.push_back(argv[++i]);
+            else if (arg.starts_with("--shard="))
+            {
+                if (!parse_shard(arg.substr(8), options.shard_index,
+                                 options.shard_count))
+                {
+                    std::cerr << argv[0] << ": invalid shard '"
+                              << arg.substr(8)
+                              << "', expected I/N with 1 <= I <= N\n";
+                    print_usage(std::cerr, argv[0]);
+                    return false;
+                }
+            }
+            else if (arg == "--list")
+                options.list_tests = true;
+            else if (arg.starts_with("--benchmark=")
+                     || arg.starts_with("--warmup=")
+                     || arg.starts_with("--pin=")
+                     || arg.starts_with("--loops="))
+            {
+                auto equal = arg.find('=');
+                auto value = arg.substr(equal + 1);
+                std::size_t number = 0;
+                auto [end, error] = std::from_chars(
+                    value.data(), value.data() + value.size(), number);
+                if (error != std::errc{} || end != value.data() + value.size())
+                {
+                    std::cerr << argv[0] << ": invalid number '" << value
+                              << "' for " << arg.substr(0, equal) << '\n';
+                    print_usage(std::cerr, argv[0]);
+                    return false;
                 }
+                if (arg.starts_with("--benchmark="))
+                    options.benchmark_runs = number;
+                else if (arg.starts_with("--warmup="))
+                    options.benchmark_warmups = number;
+                else if (arg.starts_with("--loops="))
+                    options.event_loops = number;
+                else
+                    options.benchmark_cpu = static_cast<int>(number);
+            }
+            else if (arg == "--serial")
+                options.benchmark_serial = true;
+            else if (arg.starts_with("--baseline="))
+                options.benchmark_baseline = argv[i] + 11;
+            else if (arg.starts_with("--save="))
+                options.benchmark_save = argv[i] + 7;
+            else if (arg.starts_with("--cache="))
+                options.result_cache = argv[i] + 8;
+            else if (arg.starts_with("--history="))
+                options.history_file = argv[i] + 10;
+            else if (arg == "--help" || arg == "-h")
+            {
+                print_usage(std::cout, argv[0]);
+                std::exit(0);
+            }
+            else
+            {
+                std::cerr << argv[0] << ": unknown argument '" << arg << "'\n";
+                print_usage(std::cerr, argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static inline std::size_t online_cores()
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        return cores > 0 ? static_cast<std::size_t>(cores) : 1;
+    }
+
+    // Descriptors a test may hold at once while it is being launched: both
+    // ends of its three pipes, its stdin file, its pidfd and its timerfd, and
+    // both ends of the pipe telling whether the execv of the fork backend
+    // went through
+    inline constexpr std::size_t FDS_PER_SLOT = 11;
+    // Left to the runner itself: stdio, event loops, reports, golden files...
+    inline constexpr std::size_t RESERVED_FDS = 64;
+
+    // Never more than the limit on open files allows, the launches would
+    // fail instead of waiting for a free slot
+    static inline std::size_t job_slots(RunnerOptions const& options)
+    {
+        std::size_t slots =
+            options.max_in_flight > 0 ? options.max_in_flight : online_cores();
+
+        rlimit open_files;
+        if (getrlimit(RLIMIT_NOFILE, &open_files) == 0
+            && open_files.rlim_cur != RLIM_INFINITY)
+        {
+            std::size_t limit = open_files.rlim_cur;
+            std::size_t fitting = limit > RESERVED_FDS
+                ? (limit - RESERVED_FDS) / FDS_PER_SLOT
+                : 0;
+            slots = std::min(slots, std::max<std::size_t>(fitting, 1));
+        }
+        return slots;
+    }
+
+    static inline std::size_t validation_threads(RunnerOptions const& options)
+    {
+        if (options.validation_threads > 0)
+            return options.validation_threads;
+        return online_cores();
+    }
+
+    // Never more loops than slots, each of them runs at least one test at a
+    // time
+    static inline std::size_t event_loops(RunnerOptions const& options,
+                                          std::size_t slots)
+    {
+        std::size_t loops =
+            options.event_loops > 0 ? options.event_loops : online_cores();
+        return std::clamp<std::size_t>(loops, 1, slots);
+    }
+
+    // The slots of the l-th of `loops` event loops
+    static inline std::size_t loop_slots(std::size_t slots, std::size_t loops,
+                                         std::size_t l)
+    {
+        return slots / loops + (l < slots % loops ? 1 : 0);
+    }
+
+    namespace Caching
+    {
+        static constexpr std::uint64_t MULTIPLIER = 0x9e3779b97f4a7c15;
+
+        static constexpr std::uint64_t mix(std::uint64_t hash,
+                                           std::uint64_t word)
+        {
+            return std::rotl((hash ^ word) * MULTIPLIER, 31);
+        }
+
+        // Murmur3's finalizer, so that every input bit reaches every output
+        // bit
+        static constexpr std::uint64_t finalize(std::uint64_t hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccd;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53;
+            return hash ^ (hash >> 33);
+        }
+
+        // Only meant to notice changes, nothing cryptographic. Eight bytes at
+        // a time, the byte by byte loads are merged by the compiler outside
+        // of constant evaluation.
+        static constexpr std::uint64_t hash_bytes(std::string_view bytes,
+                                                  std::uint64_t seed = 0)
+        {
+            auto word_at = [&](std::size_t at, std::size_t count) {
+                std::uint64_t word = 0;
+                for (std::size_t b = 0; b < count; ++b)
+                    word |= std::uint64_t{ static_cast<unsigned char>(
+                                bytes[at + b]) }
+                        << (8 * b);
+                return word;
+            };
+
+            std::uint64_t hash = mix(seed, bytes.size());
+            std::size_t i = 0;
+            for (; i + 8 <= bytes.size(); i += 8)
+                hash = mix(hash, word_at(i, 8));
+            if (i < bytes.size())
+                hash = mix(hash, word_at(i, bytes.size() - i));
+            return finalize(hash);
+        }
+
+        // The full name of the test's type, which spells out every template
+        // argument of its builder. Lambdas all look alike in it, what their
+        // code does is covered by the hash of the runner's own executable.
+        template <typename Test>
+        consteval std::string_view signature()
+        {
+            return __PRETTY_FUNCTION__;
+        }
+
+        // Everything about the test that is known at compile time. The files
+        // it refers to are only hashed when the tests run.
+        template <typename Test>
+        consteval std::uint64_t definition_hash()
+        {
+            std::uint64_t hash = hash_bytes(signature<Test>());
+            hash = hash_bytes(Test::test_name, hash);
+            hash = hash_bytes(Test::stdinput, hash);
+            for (char const* arg : Test::command_line_argv)
+                hash = hash_bytes(arg, hash);
+            for (char const* path :
+                 { Test::stdin_file, Test::stdout_file, Test::stderr_file })
+                hash = hash_bytes(path ? path : "", hash);
+            for (std::size_t limit :
+                 { Test::limits.max_capture, Test::limits.timeout_ms,
+                   Test::limits.max_wall_time_ms, Test::limits.max_cpu_time_ms,
+                   Test::limits.max_rss,
+                   static_cast<std::size_t>(Test::limits.stdin_delivery) })
+                hash = mix(hash, limit);
+            return finalize(hash);
+        }
+
+        // A whole file, mapped a window at a time and released as it goes
+        // (see MappedFile::release). Empty if it cannot be read.
+        static inline std::optional<std::uint64_t> hash_file(char const* path)
+        {
+            MappedFile file(path);
+            if (!file)
+                return std::nullopt;
+
+            constexpr std::size_t window = 1 << 20;
+            std::string_view content = file.view();
+            std::uint64_t hash = content.size();
+            for (std::size_t begin = 0; begin < content.size();
+                 begin += window)
+            {
+                std::size_t end = std::min(begin + window, content.size());
+                hash = hash_bytes(content.substr(begin, end - begin), hash);
+                file.release(begin, end);
+            }
+            return hash;
+        }
+
+        // Tests that passed, known by their key: the hashes of the binary, of
+        // the test's definition and of the files it refers to. Saved as one
+        // test per line, the key in hex and then the name, for humans.
+        class ResultCache
+        {
+        public:
+            explicit ResultCache(char const* path_)
+                : path(path_)
+            {
+                // Nothing was cached yet on the first run
+                std::ifstream in(path);
+                std::uint64_t key;
+                std::string name;
+                while (in >> std::hex >> key)
+                {
+                    in.get();
+                    std::getline(in, name);
+                    entries[key] = std::move(name);
+                }
+            }
+
+            bool passed(std::uint64_t key) const
+            {
+                return entries.contains(key);
+            }
+
+            // Forgets the earlier keys of the tests named in `names`, which
+            // cannot pass again, before remembering the ones that passed now
+            void update(std::span<std::string_view const> names,
+                        std::span<std::optional<std::uint64_t> const> keys,
+                        std::span<TestReport const> reports)
+            {
+                std::unordered_set<std::string_view> ran(names.begin(),
+                                                         names.end());
+                std::erase_if(entries, [&](auto const& entry) {
+                    return ran.contains(entry.second);
+                });
+                for (std::size_t i = 0; i < reports.size(); ++i)
+                {
+                    bool passed = reports[i].verdict == Verdict::Pass
+                        || reports[i].verdict == Verdict::Cached;
+                    if (passed && keys[i])
+                        entries[*keys[i]] = names[i];
+                }
+            }
+
+            void save() const
+            {
+                replace_file(path, [&](std::ofstream& out) {
+                    out << std::hex << std::setfill('0');
+                    for (auto const& [key, name] : entries)
+                        out << std::setw(16) << key << ' ' << name << '\n';
+                });
+            }
+
+        private:
+            char const* path;
+            std::unordered_map<std::uint64_t, std::string> entries;
+        };
+    } // namespace Caching
+    using Caching::ResultCache;
+
+    // Should be all filled at comptime
+    struct StaticProcessData
+    {
+        std::string_view test_name;
+        std::string_view stdinput;
+        // Null when the stdin is the stdinput
+        char const* stdin_file;
+        // Null when the output is not matched against a file
+        char const* stdout_file;
+        char const* stderr_file;
+        bool (*stdout_validation)(std::string_view);
+        bool (*stderr_validation)(std::string_view);
+        bool (*exit_code_validation)(int);
+        StreamValidation stdout_stream_validation;
+        StreamValidation stderr_stream_validation;
+        // Handed to the stream validators in their cursor (see TestMatrix)
+        std::string_view expected_stdout;
+        std::string_view expected_stderr;
+
+        // Null when it is the one of the runner
+        char const* binary;
+        // Without argv[0], which is the binary
+        char const* const* command_line_argv;
+        std::size_t command_line_argc;
+
+        TestLimits limits;
+
+        // Identifies the test in the result cache, along with its files
+        std::uint64_t definition_hash;
+    };
+
+    template <TestCase Test>
+    inline constexpr StaticProcessData static_process_data = {
+        Test::test_name,
+        Test::stdinput,
+        Test::stdin_file,
+        Test::stdout_file,
+        Test::stderr_file,
+        Test::validate_stdout,
+        Test::validate_stderr,
+        Test::validate_exit_code,
+        Test::stream_validate_stdout,
+        Test::stream_validate_stderr,
+        {},
+        {},
+        Test::binary,
+        Test::command_line_argv.data(),
+        Test::command_line_argc,
+        Test::limits,
+        Caching::definition_hash<Test>(),
+    };
+
+    // REGISTER_TEST puts a pointer to each test in this section. The linker
+    // gathers them from every translation unit, and defines these two symbols
+    // around them (they stay null when nothing was registered). It pads the
+    // entries to their alignment with zeros, hence the null slots.
+    [[gnu::weak]] extern StaticProcessData const* const
+        registry_begin[] __asm__("__start_tuncfest_tests");
+    [[gnu::weak]] extern StaticProcessData const* const
+        registry_end[] __asm__("__stop_tuncfest_tests");
+
+    // Every registered test of the program. The link order depends on the
+    // toolchain, so they are sorted by name to always run in the same order.
+    // A test registered from a header comes once per translation unit
+    // including it, those with the same name and definition are only kept
+    // once. Entries cannot be merged by the linker instead: the compiler puts
+    // all those of a translation unit in a single section, which would then
+    // be dropped as a whole.
+    static inline std::vector<StaticProcessData> registered_tests()
+    {
+        std::vector<StaticProcessData> tests;
+        if (!registry_begin)
+            return tests;
+
+        tests.reserve(static_cast<std::size_t>(registry_end - registry_begin));
+        for (auto it = registry_begin; it != registry_end; ++it)
+            if (*it)
+                tests.push_back(**it);
+        auto identity = [](StaticProcessData const& test) {
+            return std::tie(test.test_name, test.definition_hash);
+        };
+        std::stable_sort(tests.begin(), tests.end(),
+                         [&](auto const& lhs, auto const& rhs) {
+                             return identity(lhs) < identity(rhs);
+                         });
+        auto copies = std::unique(tests.begin(), tests.end(),
+                                  [&](auto const& lhs, auto const& rhs) {
+                                      return identity(lhs) == identity(rhs);
+                                  });
+        tests.erase(copies, tests.end());
+        return tests;
+    }
+
+    // A base builder and tables of cases, combined into as many tests without
+    // a template instantiation per test. The tests come out as one array of
+    // StaticProcessData, their names and arguments laid out in a single pool
+    // of characters, so compile time and binary size grow with the number of
+    // cases rather than with their template depth.
+    namespace Matrices
+    {
+        // Only ever called at compile time, to stop the compilation
+        void too_many_matrix_arguments();
+
+        // Arguments of a case. There is room for a fixed number of them, so
+        // that the tables stay literal types.
+        struct MatrixArgs
+        {
+            std::array<std::string_view, 16> values{};
+            std::size_t count = 0;
+
+            constexpr MatrixArgs() = default;
+
+            consteval MatrixArgs(std::initializer_list<std::string_view> args)
+                : count(args.size())
+            {
+                if (args.size() > values.size())
+                    too_many_matrix_arguments();
+                std::copy(args.begin(), args.end(), values.begin());
+            }
+        };
+
+        // A row of a table. What it leaves unset comes from the other tables
+        // of the case, or from the base builder, and its arguments come after
+        // theirs. The last table setting a field wins.
+        struct MatrixCase
+        {
+            std::string_view name = {};
+            std::optional<std::string_view> stdinput = {};
+            MatrixArgs args = {};
+            // Matched as the outputs stream, like with_stdout_match
+            std::optional<std::string_view> expected_stdout = {};
+            std::optional<std::string_view> expected_stderr = {};
+        };
+
+        enum class Combination
+        {
+            // Every row of each table with every row of the others
+            Product,
+            // The i-th row of each table together
+            Zip,
+        };
+
+        template <Combination How, auto Base, auto const&... Tables>
+        class Matrix
+        {
+            using BaseTest = typename decltype(Base)::Result;
+            static constexpr std::size_t NumTables = sizeof...(Tables);
+            static_assert(NumTables > 0, "A matrix needs at least one table");
+
+            static constexpr std::array<std::span<MatrixCase const>, NumTables>
+                tables = { std::span<MatrixCase const>(Tables)... };
+
+            static consteval std::size_t count_cases()
+            {
+                std::size_t count = How == Combination::Product ? 1 : 0;
+                for (auto table : tables)
+                    count = How == Combination::Product
+                        ? count * table.size()
+                        : std::max(count, table.size());
+                return count;
+            }
+
+            static consteval bool zippable()
+            {
+                for (auto table : tables)
+                    if (table.size() != tables[0].size())
+                        return false;
+                return true;
+            }
+            static_assert(How == Combination::Product || zippable(),
+                          "Zipped tables need as many rows");
+
+            // Case names join those of their rows with '/', leaving out the
+            // empty ones. They only tell the cases apart when no row name
+            // holds a '/', only the rows alone in their table go unnamed, and
+            // the rows of a table have different names: in every table for a
+            // product, in one of them at least when zipped.
+            static consteval bool named_rows()
+            {
+                for (auto table : tables)
+                    for (auto const& row : table)
+                        if ((row.name.empty() && table.size() > 1)
+                            || row.name.contains('/'))
+                            return false;
+                return true;
+            }
+            static_assert(named_rows(),
+                          "Rows need a name without '/', unless they are "
+                          "alone in their table");
+
+            static consteval bool distinct_names(
+                std::span<MatrixCase const> table)
+            {
+                std::vector<std::string_view> names;
+                for (auto const& row : table)
+                    names.push_back(row.name);
+                std::sort(names.begin(), names.end());
+                return std::adjacent_find(names.begin(), names.end())
+                    == names.end();
+            }
+
+            static consteval bool distinct_cases()
+            {
+                bool every = true, any = false;
+                for (auto table : tables)
+                {
+                    bool distinct = distinct_names(table);
+                    every = every && distinct;
+                    any = any || distinct;
+                }
+                return How == Combination::Product ? every : any;
+            }
+            static_assert(distinct_cases(),
+                          "Two cases would have the same name, give the "
+                          "rows of a table different names");
+
+        public:
+            static constexpr std::size_t size = count_cases();
+
+        private:
+            static constexpr std::size_t NumRows = (std::size(Tables) + ...);
+            static constexpr std::size_t NumArgs = []() consteval {
+                std::size_t count = 0;
+                for (auto table : tables)
+                    for (auto const& row : table)
+                        count += row.args.count;
+                return count;
+            }();
+
+            // The rows of every table one after the other, with what the
+            // cases need of them
+            struct RowInfo
+            {
+                MatrixCase const* row = nullptr;
+                // Its first argument in row_args
+                std::size_t first_arg = 0;
+                // Hashed once per row rather than once per case
+                std::uint64_t hash = 0;
+            };
+
+            static consteval std::uint64_t row_hash(MatrixCase const& row)
+            {
+                using Caching::hash_bytes;
+                std::uint64_t hash = hash_bytes(row.name);
+                for (auto const* field :
+                     { &row.stdinput, &row.expected_stdout,
+                       &row.expected_stderr })
+                    hash = field->has_value()
+                        ? hash_bytes(**field, Caching::mix(hash, 1))
+                        : Caching::mix(hash, 0);
+                for (std::size_t a = 0; a < row.args.count; ++a)
+                    hash = hash_bytes(row.args.values[a], hash);
+                return hash;
+            }
+
+            static constexpr std::array<RowInfo, NumRows> rows =
+                []() consteval {
+                    std::array<RowInfo, NumRows> rows{};
+                    std::size_t at = 0, first_arg = 0;
+                    for (auto table : tables)
+                        for (auto const& row : table)
+                        {
+                            rows[at++] = { &row, first_arg, row_hash(row) };
+                            first_arg += row.args.count;
+                        }
+                    return rows;
+                }();
+
+            // Where each table starts in `rows`
+            static constexpr std::array<std::size_t, NumTables> table_rows =
+                []() consteval {
+                    std::array<std::size_t, NumTables> starts{};
+                    for (std::size_t t = 1; t < NumTables; ++t)
+                        starts[t] = starts[t - 1] + tables[t - 1].size();
+                    return starts;
+                }();
+
+            static constexpr std::size_t table_sizes[NumTables] = {
+                std::size(Tables)...
+            };
+
+            // Indices in `rows` of the rows of a case
+            struct CaseRows
+            {
+                std::size_t of[NumTables];
+            };
+
+            // Done for every case, unlike everything above. Subscripts go
+            // through pointers and built-in arrays: a call to operator[] per
+            // subscript is most of the compile time of the big matrices.
+            static constexpr CaseRows rows_of(std::size_t c)
+            {
+                CaseRows result{};
+                std::size_t const* starts = table_rows.data();
+                for (std::size_t t = NumTables; t-- > 0;)
+                {
+                    std::size_t row = c;
+                    if constexpr (How == Combination::Product)
+                    {
+                        row = c % table_sizes[t];
+                        c /= table_sizes[t];
+                    }
+                    result.of[t] = starts[t] + row;
+                }
+                return result;
+            }
+
+            static constexpr std::size_t name_size(CaseRows const& of)
+            {
+                RowInfo const* info = rows.data();
+                std::size_t size = std::string_view(BaseTest::test_name).size();
+                for (std::size_t r : of.of)
+                    if (!info[r].row->name.empty())
+                        size += (size > 0) + info[r].row->name.size();
+                return size;
+            }
+
+            static constexpr std::size_t argc_of(CaseRows const& of)
+            {
+                RowInfo const* info = rows.data();
+                std::size_t argc = BaseTest::command_line_argc;
+                for (std::size_t r : of.of)
+                    argc += info[r].row->args.count;
+                return argc;
+            }
+
+            // The arguments open the pool, each of them once with its NUL,
+            // and the names follow in case order
+            struct Arguments
+            {
+                std::array<std::string_view, NumArgs> distinct{};
+                std::size_t count = 0;
+                std::size_t chars = 0;
+                // Offset in the pool of each argument of each row
+                std::array<std::size_t, NumArgs> offsets{};
+            };
+
+            static constexpr Arguments arguments = []() consteval {
+                Arguments args;
+                for (auto table : tables)
+                    for (auto const& row : table)
+                        for (std::size_t a = 0; a < row.args.count; ++a)
+                            args.distinct[args.count++] = row.args.values[a];
+
+                auto first = args.distinct.begin();
+                auto last = first + static_cast<std::ptrdiff_t>(args.count);
+                std::sort(first, last);
+                last = std::unique(first, last);
+                args.count = static_cast<std::size_t>(last - first);
+
+                std::array<std::size_t, NumArgs> distinct_offsets{};
+                for (std::size_t a = 0; a < args.count; ++a)
+                {
+                    distinct_offsets[a] = args.chars;
+                    args.chars += args.distinct[a].size() + 1;
+                }
+
+                std::size_t at = 0;
+                for (auto table : tables)
+                    for (auto const& row : table)
+                        for (std::size_t a = 0; a < row.args.count; ++a)
+                            args.offsets[at++] = distinct_offsets[
+                                static_cast<std::size_t>(
+                                    std::lower_bound(first, last,
+                                                     row.args.values[a])
+                                    - first)];
+                return args;
+            }();
+
+            static constexpr std::size_t PoolSize = []() consteval {
+                std::size_t size = arguments.chars;
+                for (std::size_t c = 0; c < Matrix::size; ++c)
+                    size += name_size(rows_of(c));
+                return size;
+            }();
+
+            static constexpr std::size_t ArgvSize = []() consteval {
+                std::size_t size = 0;
+                for (std::size_t c = 0; c < Matrix::size; ++c)
+                    size += argc_of(rows_of(c));
+                return size;
+            }();
+
+            static constexpr std::array<char, PoolSize> pool = []() consteval {
+                std::array<char, PoolSize> pool{};
+                char* out = pool.data();
+                auto append = [&](std::string_view text) {
+                    out = std::copy(text.begin(), text.end(), out);
+                };
+
+                for (std::size_t a = 0; a < arguments.count; ++a)
+                {
+                    append(arguments.distinct[a]);
+                    *out++ = '\0';
+                }
+
+                RowInfo const* info = rows.data();
+                for (std::size_t c = 0; c < Matrix::size; ++c)
+                {
+                    char const* start = out;
+                    append(BaseTest::test_name);
+                    for (std::size_t r : rows_of(c).of)
+                    {
+                        if (info[r].row->name.empty())
+                            continue;
+                        if (out != start)
+                            *out++ = '/';
+                        append(info[r].row->name);
+                    }
+                }
+                return pool;
+            }();
+
+            static constexpr std::array<char const*, ArgvSize> argv =
+                []() consteval {
+                    std::array<char const*, ArgvSize> argv{};
+                    char const** out = argv.data();
+                    RowInfo const* info = rows.data();
+                    std::size_t const* offsets = arguments.offsets.data();
+                    for (std::size_t c = 0; c < Matrix::size; ++c)
+                    {
+                        for (char const* arg : BaseTest::command_line_argv)
+                            *out++ = arg;
+                        for (std::size_t r : rows_of(c).of)
+                            for (std::size_t a = 0;
+                                 a < info[r].row->args.count; ++a)
+                                *out++ = pool.data()
+                                    + offsets[info[r].first_arg + a];
+                    }
+                    return argv;
+                }();
+
+        public:
+            static constexpr std::array<StaticProcessData, size> tests =
+                []() consteval {
+                    std::array<StaticProcessData, size> tests{};
+                    StaticProcessData* test = tests.data();
+                    RowInfo const* info = rows.data();
+                    std::size_t name_at = arguments.chars;
+                    std::size_t argv_at = 0;
+                    for (std::size_t c = 0; c < size; ++c, ++test)
+                    {
+                        CaseRows of = rows_of(c);
+                        *test = static_process_data<BaseTest>;
+                        test->test_name = std::string_view(
+                            pool.data() + name_at, name_size(of));
+                        test->command_line_argv = argv.data() + argv_at;
+                        test->command_line_argc = argc_of(of);
+                        name_at += test->test_name.size();
+                        argv_at += test->command_line_argc;
+
+                        std::uint64_t hash = test->definition_hash;
+                        for (std::size_t r : of.of)
+                        {
+                            MatrixCase const& row = *info[r].row;
+                            hash = Caching::mix(hash, info[r].hash);
+                            if (row.stdinput)
+                            {
+                                test->stdinput = *row.stdinput;
+                                test->stdin_file = nullptr;
+                            }
+                            if (row.expected_stdout)
+                            {
+                                test->expected_stdout = *row.expected_stdout;
+                                test->stdout_validation =
+                                    TestBuilderClass::accept_any_output;
+                                test->stdout_stream_validation =
+                                    TestBuilderClass::stream_match_expected;
+                                test->stdout_file = nullptr;
+                            }
+                            if (row.expected_stderr)
+                            {
+                                test->expected_stderr = *row.expected_stderr;
+                                test->stderr_validation =
+                                    TestBuilderClass::accept_any_output;
+                                test->stderr_stream_validation =
+                                    TestBuilderClass::stream_match_expected;
+                                test->stderr_file = nullptr;
+                            }
+                        }
+                        test->definition_hash = Caching::finalize(hash);
+                    }
+                    return tests;
+                }();
+
+            // For REGISTER_TEST_MATRIX
+            static constexpr std::array<StaticProcessData const*, size>
+                registry = []() consteval {
+                    std::array<StaticProcessData const*, size> registry{};
+                    for (std::size_t c = 0; c < size; ++c)
+                        registry.data()[c] = tests.data() + c;
+                    return registry;
+                }();
+        };
+
+        // Every combination of a row of each table
+        template <auto Base, auto const&... Tables>
+        using TestMatrix = Matrix<Combination::Product, Base, Tables...>;
+
+        // The rows of the same rank in each table, which must be as long
+        template <auto Base, auto const&... Tables>
+        using ZippedTestMatrix = Matrix<Combination::Zip, Base, Tables...>;
+    } // namespace Matrices
+    using Matrices::MatrixCase;
+    using Matrices::TestMatrix;
+    using Matrices::ZippedTestMatrix;
+
+// Registers every test of a matrix, the way REGISTER_TEST does for a single
+// one, headers included. The compiler would align a big array on more than a
+// pointer, leaving holes between it and the other entries.
+#define REGISTER_TEST_MATRIX(NAME, ...)                                        \
+    using NAME = __VA_ARGS__;                                                  \
+    static_assert(NAME::size > 0, "An empty matrix has nothing to register"); \
+    [[gnu::used, gnu::retain, gnu::section("tuncfest_tests")]] alignas(        \
+        ::Runner::StaticProcessData const*) static constexpr auto              \
+        tuncfest_registered_##NAME = NAME::registry
+
+    // Only * (any sequence) and ? (any character). A * failing to match
+    // further only needs to retry one character later, so this is linear in
+    // practice.
+    static constexpr bool glob_match(std::string_view pattern,
+                                     std::string_view text)
+    {
+        std::size_t p = 0, t = 0;
+        std::size_t star = std::string_view::npos, retry = 0;
+        while (t < text.size())
+        {
+            if (p < pattern.size()
+                && (pattern[p] == '?' || pattern[p] == text[t]))
+            {
+                ++p;
+                ++t;
+            }
+            else if (p < pattern.size() && pattern[p] == '*')
+            {
+                star = p++;
+                retry = t;
+            }
+            else if (star != std::string_view::npos)
+            {
+                p = star + 1;
+                t = ++retry;
+            }
+            else
+                return false;
+        }
+        while (p < pattern.size() && pattern[p] == '*')
+            ++p;
+        return p == pattern.size();
+    }
+
+    static inline bool is_selected(std::string_view name,
+                                   RunnerOptions const& options)
+    {
+        bool has_inclusions = false;
+        bool included = false;
+        for (auto filter : options.filters)
+        {
+            if (filter.starts_with('-'))
+            {
+                if (glob_match(filter.substr(1), name))
+                    return false;
+            }
+            else
+            {
+                has_inclusions = true;
+                included = included || glob_match(filter, name);
+            }
+        }
+        return included || !has_inclusions;
+    }
+
+    // Filters first, then shards round-robin over what is left, so that the
+    // shards keep the same size whatever the filters. Only depends on the
+    // order of the tests, which is deterministic.
+    static inline std::vector<StaticProcessData>
+    select_tests(std::span<StaticProcessData const> tests,
+                 RunnerOptions const& options)
+    {
+        std::vector<StaticProcessData> selected;
+        std::size_t matched = 0;
+        for (auto const& test : tests)
+        {
+            if (!is_selected(test.test_name, options))
+                continue;
+            if (matched++ % options.shard_count == options.shard_index - 1)
+                selected.push_back(test);
+        }
+        return selected;
+    }
+
+    // Not inferable in comptime
+    struct RuntimeProcess
+    {
+        OutputBuffer stdout_buff;
+        OutputBuffer stderr_buff;
+
+        pid_t pid = -1;
+        // Readable once the child exited, -1 if the kernel has no pidfd
+        int pid_fd = -1;
+        // Filled by wait4 once the child was reaped
+        int status = 0;
+        // Set as soon as the child exited. It is only reaped once the test is
+        // over: until then its id cannot be reused, and kill_group still
+        // reaches whatever it left running in its group.
+        bool exited = false;
+        bool reaped = false;
+        ResourceUsage usage;
+        // Passed in an earlier run, never launched
+        bool cached = false;
+
+        // Progress of the streaming validators, if any. A rejected stream gets
+        // the test killed right away.
+        StreamCursor stdout_cursor;
+        StreamCursor stderr_cursor;
+        bool stdout_rejected = false;
+        bool stderr_rejected = false;
+        // Set when that kill is what ended the test, its exit code is then
+        // ours rather than the test's
+        bool killed_on_rejection = false;
+        // Never started, the reason is in stderr_buff
+        bool launch_failed = false;
+
+        int stdin_fd = -1;
+        // The with_stdin_file being spliced into stdin_fd
+        int stdin_file_fd = -1;
+        int stdout_fd = -1;
+        int stderr_fd = -1;
+        // The test is done when this reaches 0 and the child exited, stdin is
+        // not counted
+        int open_streams = 0;
+
+        // How much of the stdinput was already fed to the child
+        std::size_t stdin_written = 0;
+
+        // timerfd firing at the deadline, then at the end of the kill grace
+        int timer_fd = -1;
+        std::size_t timeout_ms = 0;
+        // Set once the SIGTERM was sent
+        bool timed_out = false;
+
+        // Filled by the validation pool once the test is over
+        bool passed_exit_code = false;
+        bool passed_stdout = false;
+        bool passed_stderr = false;
+    };
+
+    // Runs the validators of the finished tests on a few threads, while the
+    // other tests are still running. Validated tests come back through a
+    // lock-free stack, and an eventfd wakes up the epoll loop.
+    class ValidationPool
+    {
+    public:
+        using Work = void (*)(StaticProcessData const&, RuntimeProcess&);
+
+        ValidationPool(std::size_t threads, Work work_,
+                       std::span<StaticProcessData const> tests_,
+                       std::vector<RuntimeProcess>& processes_)
+            : work(work_)
+            , tests(tests_)
+            , processes(processes_)
+            , links(processes_.size(), NONE)
+        {
+            jobs.reserve(processes.size());
+
+            event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (event_fd == -1)
+            {
+                // Still works, just without the threads
+                perror("eventfd");
+                return;
+            }
+
+            threads = std::min(threads, processes.size());
+            workers.reserve(threads);
+            for (std::size_t i = 0; i < threads; ++i)
+                workers.emplace_back([this]() { run(); });
+        }
+
+        ValidationPool(ValidationPool const&) = delete;
+        ValidationPool& operator=(ValidationPool const&) = delete;
+
+        ~ValidationPool()
+        {
+            {
+                std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            wakeup.notify_all();
+            for (auto& worker : workers)
+                worker.join();
+
+            if (event_fd != -1)
+                close(event_fd);
+        }
+
+        // Readable whenever something was validated, -1 if there is no
+        // thread in which case submit validates right away
+        int fd() const
+        {
+            return event_fd;
+        }
+
+        // The test must not be touched until it comes back from drain
+        void submit(std::size_t i)
+        {
+            if (workers.empty())
+            {
+                work(tests[i], processes[i]);
+                push(i);
+                return;
+            }
+
+            {
+                std::lock_guard lock(mutex);
+                jobs.push_back(i);
+            }
+            wakeup.notify_one();
+        }
+
+        // Resets fd() once it was reported readable, tests validated before
+        // that are picked up by the next drain
+        void acknowledge()
+        {
+            std::uint64_t count;
+            if (read(event_fd, &count, sizeof(count)) == -1 && errno != EAGAIN)
+                perror("read");
+        }
+
+        // Calls f on every test validated since the last call, in no
+        // particular order
+        void drain(auto&& f)
+        {
+            std::size_t i = validated.exchange(NONE, std::memory_order_acquire);
+            while (i != NONE)
+            {
+                std::size_t next = links[i];
+                f(i);
+                i = next;
+            }
+        }
+
+    private:
+        static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+        void run()
+        {
+            for (;;)
+            {
+                std::size_t i;
+                {
+                    std::unique_lock lock(mutex);
+                    wakeup.wait(lock, [this]() {
+                        return stopping || taken < jobs.size();
+                    });
+                    if (taken == jobs.size())
+                        return;
+                    i = jobs[taken++];
+                }
+
+                work(tests[i], processes[i]);
+                push(i);
+
+                std::uint64_t one = 1;
+                if (write(event_fd, &one, sizeof(one)) == -1)
+                    perror("write");
+            }
+        }
+
+        // Each test is pushed once, and the consumer takes the whole stack at
+        // once, so there is no ABA to care about
+        void push(std::size_t i)
+        {
+            std::size_t head = validated.load(std::memory_order_relaxed);
+            do
+                links[i] = head;
+            while (!validated.compare_exchange_weak(head, i,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed));
+        }
+
+        Work work;
+        std::span<StaticProcessData const> tests;
+        std::vector<RuntimeProcess>& processes;
+
+        // Jobs are only ever appended, `taken` is the next one to run
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::vector<std::size_t> jobs;
+        std::size_t taken = 0;
+        bool stopping = false;
+
+        // Intrusive stack of validated tests, links[i] is the one below i
+        std::vector<std::size_t> links;
+        std::atomic<std::size_t> validated{ NONE };
+
+        int event_fd = -1;
+        std::vector<std::thread> workers;
+    };
+
+    // What an epoll event is about. It is packed with the index of the process
+    // in the event's u64, so an event resolves to its buffer without any
+    // lookup.
+    enum class StreamKind : std::uint64_t
+    {
+        Stdin = 0,
+        Stdout = 1,
+        Stderr = 2,
+        Timer = 3,
+        Exit = 4,
+        // Not about a process, the validation pool has results for us
+        Validated = 5,
+    };
+
+    static constexpr std::uint64_t STREAM_KIND_BITS = 3;
+
+    static constexpr std::uint64_t encode_event(std::size_t i, StreamKind kind)
+    {
+        std::uint64_t index = i;
+        return (index << STREAM_KIND_BITS) | static_cast<std::uint64_t>(kind);
+    }
+
+    static constexpr std::size_t event_process(std::uint64_t data)
+    {
+        std::size_t index = data >> STREAM_KIND_BITS;
+        return index;
+    }
+
+    static constexpr StreamKind event_kind(std::uint64_t data)
+    {
+        return static_cast<StreamKind>(data
+                                       & ((1u << STREAM_KIND_BITS) - 1));
+    }
+
+    // What the event loop reports, whatever its backend. Outputs are read by
+    // the backend: `chunk` then holds `result` bytes, or `result` is a
+    // negated errno.
+    struct IoEvent
+    {
+        std::uint64_t data;
+        char const* chunk = nullptr;
+        int result = 0;
+    };
+
+    // Bytes read from an output at once, a full pipe
+    static constexpr std::size_t READ_SIZE = 64 << 10;
+
+    // Readiness based loop, the outputs are read as they become readable.
+    // Events are level-triggered, so one read per event is enough.
+    class EpollLoop
+    {
+    public:
+        // The reads must not block the loop
+        static constexpr bool blocking_outputs = false;
+
+        EpollLoop()
+            : epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+        {
+            if (epoll_fd == -1)
+                perror("epoll_create1");
+        }
+
+        EpollLoop(EpollLoop const&) = delete;
+        EpollLoop& operator=(EpollLoop const&) = delete;
+
+        ~EpollLoop()
+        {
+            if (epoll_fd != -1)
+                close(epoll_fd);
+        }
+
+        explicit operator bool() const
+        {
+            return epoll_fd != -1;
+        }
+
+        // Stdin is waited on until writable, everything else until readable
+        void watch(int fd, std::uint64_t data)
+        {
+            bool input = event_kind(data) == StreamKind::Stdin;
+            epoll_event ev{ .events = input ? EPOLLOUT : EPOLLIN,
+                            .data = { .u64 = data } };
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        }
+
+        // Level-triggered, the fd stays watched
+        void rearm(int, std::uint64_t)
+        {}
+
+        void forget(int fd)
+        {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+
+        void close_stream(int& fd)
+        {
+            forget(fd);
+            close(fd);
+            // fd numbers get reused by the next launches
+            fd = -1;
+        }
+
+        // Reads the output an event is about
+        ssize_t read_output(IoEvent const&, int fd, char const*& chunk)
+        {
+            chunk = scratch.data();
+            return read(fd, scratch.data(), scratch.size());
+        }
+
+        // For whoever has to read by itself
+        std::span<char> scratch_buffer()
+        {
+            return scratch;
+        }
+
+        template <typename Handler>
+        void wait(Handler&& handle)
+        {
+            epoll_event events[MAX_EVENTS];
+            int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+            for (int i = 0; i < n; ++i)
+                handle(IoEvent{ .data = events[i].data.u64 });
+        }
+
+    private:
+        static constexpr int MAX_EVENTS = 64;
+
+        int epoll_fd;
+        std::array<char, READ_SIZE> scratch;
+    };
+
+#ifdef TUNCFEST_IO_URING
+    // Completion based loop. Outputs are read by the kernel into a ring of
+    // provided buffers, and the reads, polls and closes are queued in the
+    // submission ring, so a whole round of the loop costs a single
+    // io_uring_enter however many chunks it went through.
+    //
+    // Every operation is one-shot, and rearmed by the runner once it handled
+    // its completion, which keeps the level-triggered behaviour of epoll. The
+    // fd is packed in the high bits of the user data (below the event), which
+    // leaves 29 bits for the index of the test.
+    class UringLoop
+    {
+    public:
+        // The kernel waits for the data itself, but gives up on O_NONBLOCK
+        // files
+        static constexpr bool blocking_outputs = true;
+
+        // Sized for `slots` tests running at the same time
+        explicit UringLoop(std::size_t slots)
+        {
+            unsigned entries = 64;
+            while (entries < slots * 8 && entries < 4096)
+                entries *= 2;
+
+            // A single thread submits and waits, task work can wait for us
+            io_uring_params params{};
+            params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER
+                | IORING_SETUP_DEFER_TASKRUN;
+            params.cq_entries = entries * 4;
+            ring_fd = static_cast<int>(
+                syscall(SYS_io_uring_setup, entries, &params));
+            if (ring_fd == -1 && errno == EINVAL)
+            {
+                // Older kernel
+                params = io_uring_params{};
+                params.flags = IORING_SETUP_CQSIZE;
+                params.cq_entries = entries * 4;
+                ring_fd = static_cast<int>(
+                    syscall(SYS_io_uring_setup, entries, &params));
+            }
+            if (ring_fd == -1)
+                return;
+
+            if (!map_rings(params) || !provide_buffers(slots))
+            {
+                release();
+                return;
+            }
+        }
+
+        UringLoop(UringLoop const&) = delete;
+        UringLoop& operator=(UringLoop const&) = delete;
+
+        ~UringLoop()
+        {
+            release();
+        }
+
+        explicit operator bool() const
+        {
+            return ring_fd != -1;
+        }
+
+        void watch(int fd, std::uint64_t data)
+        {
+            io_uring_sqe& sqe = next_sqe();
+            sqe.fd = fd;
+            sqe.user_data = (static_cast<std::uint64_t>(fd) << FD_SHIFT) | data;
+
+            StreamKind kind = event_kind(data);
+            if (kind == StreamKind::Stdout || kind == StreamKind::Stderr)
+            {
+                sqe.opcode = IORING_OP_READ;
+                sqe.flags = IOSQE_BUFFER_SELECT;
+                sqe.buf_group = BUFFER_GROUP;
+                sqe.len = static_cast<std::uint32_t>(READ_SIZE);
+                // Pipes have no offset
+                sqe.off = static_cast<std::uint64_t>(-1);
+            }
+            else
+            {
+                sqe.opcode = IORING_OP_POLL_ADD;
+                sqe.poll32_events =
+                    kind == StreamKind::Stdin ? POLLOUT : POLLIN;
+            }
+        }
+
+        void rearm(int fd, std::uint64_t data)
+        {
+            watch(fd, data);
+        }
+
+        // Cancels whatever is pending on the fd, right away since the caller
+        // is about to close it
+        void forget(int fd)
+        {
+            cancel(fd);
+            submit();
+        }
+
+        // Queued behind the cancelation of whatever is pending on it. The fd
+        // number stays taken until the close completes, so it cannot be
+        // reused in the meantime.
+        void close_stream(int& fd)
+        {
+            // A link cannot span two submissions
+            reserve(2);
+            cancel(fd).flags |= IOSQE_IO_HARDLINK;
+            io_uring_sqe& sqe = next_sqe();
+            sqe.opcode = IORING_OP_CLOSE;
+            sqe.fd = fd;
+            sqe.user_data = IGNORED;
+            fd = -1;
+        }
+
+        // The kernel already read it, or ran out of buffers (-1, retry)
+        ssize_t read_output(IoEvent const& event, int, char const*& chunk)
+        {
+            chunk = event.chunk;
+            if (event.result == -ENOBUFS || event.result == -EAGAIN
+                || event.result == -EINTR)
+                return -1;
+            // Anything else will not get better, take it as EOF
+            return event.result < 0 ? 0 : event.result;
+        }
+
+        std::span<char> scratch_buffer()
+        {
+            return scratch;
+        }
+
+        template <typename Handler>
+        void wait(Handler&& handle)
+        {
+            // Submits whatever was queued since the last round, and waits
+            // for at least one completion
+            unsigned pending = sq_tail - load(sq.head);
+            store(sq.tail, sq_tail);
+            syscall(SYS_io_uring_enter, ring_fd, pending, 1u,
+                    IORING_ENTER_GETEVENTS, nullptr, std::size_t{ 0 });
+
+            unsigned head = *cq.head;
+            unsigned tail = load(cq.tail);
+            for (; head != tail; ++head)
+            {
+                io_uring_cqe const& cqe = cqes[head & cq.mask];
+                if (cqe.user_data == IGNORED)
+                    continue;
+
+                IoEvent event{ .data = cqe.user_data & EVENT_MASK,
+                               .result = cqe.res };
+                bool buffered = cqe.flags & IORING_CQE_F_BUFFER;
+                auto id = static_cast<std::uint16_t>(
+                    cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (buffered)
+                    event.chunk = buffers + std::size_t{ id } * READ_SIZE;
+
+                handle(event);
+
+                // Whatever the handler did with it, the chunk was consumed
+                if (buffered)
+                    recycle(id);
+            }
+            store(cq.head, head);
+        }
+
+    private:
+        static constexpr std::uint64_t FD_SHIFT = 32;
+        static constexpr std::uint64_t EVENT_MASK = (1ull << FD_SHIFT) - 1;
+        // Completions of cancels and closes, nobody waits for them
+        static constexpr std::uint64_t IGNORED = static_cast<std::uint64_t>(-1);
+        static constexpr std::uint16_t BUFFER_GROUP = 0;
+
+        struct Ring
+        {
+            unsigned* head = nullptr;
+            unsigned* tail = nullptr;
+            unsigned mask = 0;
+            unsigned entries = 0;
+        };
+
+        int ring_fd = -1;
+        Ring sq;
+        Ring cq;
+        unsigned sq_tail = 0;
+        io_uring_sqe* sqes = nullptr;
+        io_uring_cqe const* cqes = nullptr;
+        void* rings = MAP_FAILED;
+        std::size_t rings_size = 0;
+        std::size_t sqes_size = 0;
+
+        // Provided buffers, and the ring through which they are handed back
+        // to the kernel. Its entries overlay its tail, but C++ compilers put
+        // the `bufs` flexible array of the kernel header behind an empty
+        // struct, so they are indexed by hand.
+        io_uring_buf_ring* buffer_ring = nullptr;
+        io_uring_buf* buffer_entries = nullptr;
+        char* buffers = nullptr;
+        std::size_t buffer_count = 0;
+        std::size_t buffer_memory = 0;
+        std::uint16_t buffer_tail = 0;
+
+        std::array<char, READ_SIZE> scratch;
+
+        static unsigned load(unsigned const* p)
+        {
+            return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+        }
+
+        template <typename T>
+        static void store(T* p, T value)
+        {
+            __atomic_store_n(p, value, __ATOMIC_RELEASE);
+        }
+
+        static char* offset(void* base, std::uint32_t bytes)
+        {
+            return static_cast<char*>(base) + bytes;
+        }
+
+        bool map_rings(io_uring_params const& params)
+        {
+            // Both rings share a mapping since 5.4, which we require anyway
+            // for the provided buffers
+            if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+                return false;
+            rings_size = std::max(
+                params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                params.cq_off.cqes
+                    + params.cq_entries * sizeof(io_uring_cqe));
+            rings =
+                mmap(nullptr, rings_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+            if (rings == MAP_FAILED)
+                return false;
+
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes_mapping =
+                mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+            if (sqes_mapping == MAP_FAILED)
+                return false;
+            sqes = static_cast<io_uring_sqe*>(sqes_mapping);
+
+            auto ring_field = [&](std::uint32_t field) {
+                return reinterpret_cast<unsigned*>(offset(rings, field));
+            };
+            sq = { ring_field(params.sq_off.head),
+                   ring_field(params.sq_off.tail),
+                   *ring_field(params.sq_off.ring_mask), params.sq_entries };
+            cq = { ring_field(params.cq_off.head),
+                   ring_field(params.cq_off.tail),
+                   *ring_field(params.cq_off.ring_mask), params.cq_entries };
+            cqes = reinterpret_cast<io_uring_cqe const*>(
+                offset(rings, params.cq_off.cqes));
+
+            // The submission queue is indexed directly
+            unsigned* array = ring_field(params.sq_off.array);
+            for (unsigned i = 0; i < sq.entries; ++i)
+                array[i] = i;
+            sq_tail = *sq.tail;
+            return true;
+        }
+
+        // Two buffers per running test, both of its outputs can complete a
+        // read before we get to them
+        bool provide_buffers(std::size_t slots)
+        {
+            buffer_count = 16;
+            while (buffer_count < slots * 2 && buffer_count < (1 << 15))
+                buffer_count *= 2;
+
+            std::size_t ring_size = buffer_count * sizeof(io_uring_buf);
+            buffer_memory = ring_size + buffer_count * READ_SIZE;
+            void* memory = mmap(nullptr, buffer_memory, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+                return false;
+            buffer_ring = static_cast<io_uring_buf_ring*>(memory);
+            buffer_entries = static_cast<io_uring_buf*>(memory);
+            buffers = static_cast<char*>(memory) + ring_size;
+
+            io_uring_buf_reg registration{};
+            registration.ring_addr = reinterpret_cast<std::uint64_t>(memory);
+            registration.ring_entries =
+                static_cast<std::uint32_t>(buffer_count);
+            registration.bgid = BUFFER_GROUP;
+            if (syscall(SYS_io_uring_register, ring_fd,
+                        IORING_REGISTER_PBUF_RING, &registration, 1)
+                == -1)
+                return false;
+
+            for (std::size_t id = 0; id < buffer_count; ++id)
+                recycle(static_cast<std::uint16_t>(id));
+            return true;
+        }
+
+        void recycle(std::uint16_t id)
+        {
+            std::size_t mask = buffer_count - 1;
+            io_uring_buf& buffer = buffer_entries[buffer_tail & mask];
+            buffer.addr = reinterpret_cast<std::uint64_t>(
+                buffers + std::size_t{ id } * READ_SIZE);
+            buffer.len = static_cast<std::uint32_t>(READ_SIZE);
+            buffer.bid = id;
+            ++buffer_tail;
+            store(&buffer_ring->tail, buffer_tail);
+        }
+
+        // Makes room in the submission queue when it is full
+        void reserve(unsigned count)
+        {
+            if (sq.entries - (sq_tail - load(sq.head)) < count)
+                submit();
+        }
+
+        io_uring_sqe& next_sqe()
+        {
+            reserve(1);
+            io_uring_sqe& sqe = sqes[sq_tail & sq.mask];
+            sqe = io_uring_sqe{};
+            ++sq_tail;
+            return sqe;
+        }
+
+        void submit()
+        {
+            store(sq.tail, sq_tail);
+            syscall(SYS_io_uring_enter, ring_fd, sq_tail - load(sq.head), 0u,
+                    0u, nullptr, std::size_t{ 0 });
+        }
+
+        io_uring_sqe& cancel(int fd)
+        {
+            io_uring_sqe& sqe = next_sqe();
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.fd = fd;
+            sqe.cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            sqe.user_data = IGNORED;
+            return sqe;
+        }
+
+        void release()
+        {
+            // Cancels everything still pending
+            if (ring_fd != -1)
+                close(ring_fd);
+            ring_fd = -1;
+            if (rings != MAP_FAILED)
+                munmap(rings, rings_size);
+            rings = MAP_FAILED;
+            if (sqes)
+                munmap(sqes, sqes_size);
+            sqes = nullptr;
+            if (buffer_ring)
+                munmap(buffer_ring, buffer_memory);
+            buffer_ring = nullptr;
+        }
+    };
+#endif
+
+    namespace Benchmarking
+    {
+        // Spread of the measured runs of a test, in milliseconds
+        struct Distribution
+        {
+            std::size_t runs = 0;
+            double min = 0;
+            double median = 0;
+            double p95 = 0;
+            double p99 = 0;
+            double mean = 0;
+            double stddev = 0;
+        };
+
+        // Nearest-rank percentiles, and the sample standard deviation
+        static inline Distribution distribution(std::vector<double> samples)
+        {
+            Distribution result;
+            result.runs = samples.size();
+            if (samples.empty())
+                return result;
+
+            std::sort(samples.begin(), samples.end());
+            auto percentile = [&](double p) {
+                auto rank = static_cast<std::size_t>(
+                    std::ceil(p * static_cast<double>(samples.size())));
+                return samples[std::max(rank, std::size_t{ 1 }) - 1];
+            };
+            result.min = samples.front();
+            result.median = percentile(0.5);
+            result.p95 = percentile(0.95);
+            result.p99 = percentile(0.99);
+
+            double runs = static_cast<double>(samples.size());
+            double sum = 0;
+            for (double sample : samples)
+                sum += sample;
+            result.mean = sum / runs;
+
+            double squares = 0;
+            for (double sample : samples)
+                squares += (sample - result.mean) * (sample - result.mean);
+            if (samples.size() > 1)
+                result.stddev = std::sqrt(squares / (runs - 1));
+            return result;
+        }
+
+        struct BenchmarkResult
+        {
+            std::string_view test_name;
+            Distribution wall_time;
+            Distribution cpu_time;
+            // Runs that did not pass, they are measured all the same
+            std::size_t failed_runs = 0;
+        };
+
+        // Only the runs, means and standard deviations are saved, which is
+        // what the comparison needs
+        struct BaselineEntry
+        {
+            Distribution wall_time;
+            Distribution cpu_time;
+        };
+
+        using Baseline = std::unordered_map<std::string, BaselineEntry>;
+
+        // One test per line: runs, wall mean and stddev, CPU mean and stddev,
+        // then the name, last since it may contain spaces
+        static inline void
+        save_baseline(char const* path,
+                      std::vector<BenchmarkResult> const& results)
+        {
+            std::ofstream out(path);
+            if (!out)
+            {
+                perror(path);
+                return;
+            }
+            out.precision(17);
+            for (auto const& result : results)
+                out << result.wall_time.runs << ' ' << result.wall_time.mean
+                    << ' ' << result.wall_time.stddev << ' '
+                    << result.cpu_time.mean << ' ' << result.cpu_time.stddev
+                    << ' ' << result.test_name << '\n';
+        }
+
+        static inline Baseline load_baseline(char const* path)
+        {
+            Baseline baseline;
+            std::ifstream in(path);
+            if (!in)
+            {
+                perror(path);
+                return baseline;
+            }
+
+            BaselineEntry entry;
+            std::string name;
+            while (in >> entry.wall_time.runs >> entry.wall_time.mean
+                   >> entry.wall_time.stddev >> entry.cpu_time.mean
+                   >> entry.cpu_time.stddev)
+            {
+                in.get();
+                std::getline(in, name);
+                entry.cpu_time.runs = entry.wall_time.runs;
+                baseline[name] = entry;
+            }
+            return baseline;
+        }
+
+        enum class Change
+        {
+            None,
+            Slower,
+            Faster,
+        };
+
+        // Welch's t-test, with a two-sided 95% confidence: the runs of both
+        // sides are noisy, and there are not many of them
+        static inline Change compare(Distribution const& before,
+                                     Distribution const& now)
+        {
+            if (before.runs < 2 || now.runs < 2)
+                return Change::None;
+
+            double before_variance = before.stddev * before.stddev
+                / static_cast<double>(before.runs);
+            double now_variance =
+                now.stddev * now.stddev / static_cast<double>(now.runs);
+            double variance = before_variance + now_variance;
+            if (variance <= 0)
+                return Change::None;
+            double t = (now.mean - before.mean) / std::sqrt(variance);
+
+            // Welch-Satterthwaite degrees of freedom, then the critical value
+            // of Student's t from its Cornish-Fisher expansion around the
+            // normal one
+            double degrees = variance * variance
+                / (before_variance * before_variance
+                       / static_cast<double>(before.runs - 1)
+                   + now_variance * now_variance
+                       / static_cast<double>(now.runs - 1));
+            double z = 1.96;
+            double critical = z + (z * z * z + z) / (4 * degrees)
+                + (5 * std::pow(z, 5) + 16 * z * z * z + 3 * z)
+                    / (96 * degrees * degrees);
+
+            if (t > critical)
+                return Change::Slower;
+            if (t < -critical)
+                return Change::Faster;
+            return Change::None;
+        }
+
+        static inline void display_distribution(char const* label,
+                                                Distribution const& now,
+                                                BaselineEntry const* baseline,
+                                                Distribution const* before)
+        {
+            std::cout << "  " << label << " min " << now.min << "ms, median "
+                      << now.median << "ms, p95 " << now.p95 << "ms, p99 "
+                      << now.p99 << "ms, stddev " << now.stddev << "ms";
+            if (baseline && before->mean > 0)
+            {
+                double delta = (now.mean / before->mean - 1) * 100;
+                std::cout << std::showpos << " (" << delta << "%"
+                          << std::noshowpos;
+                switch (compare(*before, now))
+                {
+                case Change::Slower:
+                    std::cout << RED ", slower" RESET;
+                    break;
+                case Change::Faster:
+                    std::cout << GREEN ", faster" RESET;
+                    break;
+                default:
+                    break;
+                }
+                std::cout << ')';
+            }
+            std::cout << '\n';
+        }
+
+        // Returns true when the test got significantly slower than in the
+        // baseline
+        static inline bool display_benchmark(BenchmarkResult const& result,
+                                             Baseline const& baseline)
+        {
+            SavedFormat format;
+            std::cout << std::fixed << std::setprecision(3);
+
+            auto found = baseline.find(std::string(result.test_name));
+            BaselineEntry const* before =
+                found == baseline.end() ? nullptr : &found->second;
+
+            std::cout << BOLD << "[" << result.test_name << "] " << RESET
+                      << result.wall_time.runs << " runs";
+            if (result.failed_runs > 0)
+                std::cout << RED " (" << result.failed_runs << " failed)" RESET;
+            if (!baseline.empty() && !before)
+                std::cout << YELLOW " (not in the baseline)" RESET;
+            std::cout << '\n';
+            display_distribution("wall", result.wall_time, before,
+                                 before ? &before->wall_time : nullptr);
+            display_distribution("cpu ", result.cpu_time, before,
+                                 before ? &before->cpu_time : nullptr);
+
+            return before
+                && (compare(before->wall_time, result.wall_time)
+                        == Change::Slower
+                    || compare(before->cpu_time, result.cpu_time)
+                        == Change::Slower);
+        }
+    } // namespace Benchmarking
+    using Benchmarking::Distribution;
+    using Benchmarking::BenchmarkResult;
+    using Benchmarking::Baseline;
+
+    namespace Scheduling
+    {
+        // Wall time of each test in the earlier runs, in milliseconds
+        using History = std::unordered_map<std::string, double>;
+
+        // One test per line: the duration, then the name, last since it may
+        // contain spaces
+        static inline History load_history(char const* path)
+        {
+            // Nothing was timed yet on the first run
+            History history;
+            std::ifstream in(path);
+            double duration;
+            std::string name;
+            while (in >> duration)
+            {
+                in.get();
+                std::getline(in, name);
+                history[name] = duration;
+            }
+            return history;
+        }
+
+        static inline void save_history(char const* path,
+                                        History const& history)
+        {
+            replace_file(path, [&](std::ofstream& out) {
+                out.precision(17);
+                for (auto const& [name, duration] : history)
+                    out << duration << ' ' << name << '\n';
+            });
+        }
+
+        // Each run counts for half, so that a single noisy run does not
+        // reorder everything
+        static inline void record(History& history, std::string_view name,
+                                  double duration)
+        {
+            auto [found, inserted] =
+                history.try_emplace(std::string(name), duration);
+            if (!inserted)
+                found->second = (found->second + duration) / 2;
+        }
+
+        // Longest processing time first, which is within 4/3 of the optimal
+        // makespan. The tests that were never timed might be long ones, they
+        // go first, in declaration order.
+        static inline std::vector<std::size_t>
+        longest_first(std::span<StaticProcessData const> tests,
+                      History const& history)
+        {
+            std::vector<double> durations(tests.size(), HUGE_VAL);
+            for (std::size_t i = 0; i < tests.size(); ++i)
+            {
+                auto found = history.find(std::string(tests[i].test_name));
+                if (found != history.end())
+                    durations[i] = found->second;
+            }
+
+            std::vector<std::size_t> order(tests.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(),
+                             [&](std::size_t a, std::size_t b) {
+                                 return durations[a] > durations[b];
+                             });
+            return order;
+        }
+
+        // No schedule beats the longest test, nor the whole work spread
+        // evenly over the slots
+        static inline double
+        makespan_lower_bound(std::span<double const> durations,
+                             std::size_t slots)
+        {
+            double longest = 0;
+            double total = 0;
+            for (double duration : durations)
+            {
+                longest = std::max(longest, duration);
+                total += duration;
+            }
+            return std::max(longest, total / static_cast<double>(slots));
+        }
+
+        static inline void display_makespan(double makespan,
+                                            double lower_bound)
+        {
+            SavedFormat format;
+            std::cout << BOLD << "Makespan " << std::fixed
+                      << std::setprecision(3) << makespan / 1000
+                      << "s, lower bound " << lower_bound / 1000 << "s";
+            if (lower_bound > 0)
+                std::cout << std::showpos << std::setprecision(1) << " ("
+                          << (makespan / lower_bound - 1) * 100 << "%)"
+                          << std::noshowpos;
+            std::cout << RESET << '\n';
+        }
+    } // namespace Scheduling
+    using Scheduling::History;
+
+    // Program linked into the tests, called in place of an executable
+    using EntryPoint = int (*)(int, char**);
+
+    // Starts the tests of an entry point without execv: they are forked from
+    // this process, itself forked before the runner opens anything or starts
+    // any thread, so they inherit nothing but their stdio and skip loading
+    // and initializing the program. They are made children of the runner
+    // (CLONE_PARENT), which waits on them like on any other test.
+    class Zygote
+    {
+    public:
+        Zygote(EntryPoint entry, char const* program,
+               std::span<StaticProcessData const> tests)
+        {
+            int sockets[2];
+            if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets)
+                == -1)
+            {
+                perror("socketpair");
+                return;
+            }
+
+            // Or the tests would print it again
+            std::cout.flush();
+            std::fflush(nullptr);
+            pid = fork();
+            if (pid == -1)
+            {
+                perror("fork");
+                close(sockets[0]);
+                close(sockets[1]);
+                return;
+            }
+            if (pid == 0)
+            {
+                close(sockets[0]);
+                serve(sockets[1], entry, program, tests);
+            }
+            close(sockets[1]);
+            socket = sockets[0];
+        }
+
+        Zygote(Zygote const&) = delete;
+        Zygote& operator=(Zygote const&) = delete;
+
+        // The zygote leaves once it sees the socket closed
+        ~Zygote()
+        {
+            if (socket != -1)
+                close(socket);
+            if (pid > 0)
+                waitpid(pid, nullptr, 0);
+        }
+
+        explicit operator bool() const
+        {
+            return socket != -1;
+        }
+
+        // Starts the i-th test with these as its stdin, stdout and stderr.
+        // Returns 0, or the errno of the launch. Called by every event loop.
+        // `peak_rss` is the one of the zygote, in KiB, which the child starts
+        // with a copy of.
+        int launch(std::size_t i, int stdin_fd, int stdout_fd, int stderr_fd,
+                   pid_t& child, long& peak_rss)
+        {
+            std::lock_guard lock(mutex);
+            Descriptors fds = { stdin_fd, stdout_fd, stderr_fd };
+            if (!send_request(socket, i, fds))
+                return errno;
+
+            Reply reply;
+            ssize_t got = recv(socket, &reply, sizeof(reply), 0);
+            if (got != sizeof(reply))
+                return got == -1 ? errno : EPIPE;
+            if (reply.error != 0)
+                return reply.error;
+
+            child = reply.pid;
+            peak_rss = reply.peak_rss;
+            // Also done by the child, whoever comes first avoids the race
+            setpgid(child, child);
+            return 0;
+        }
+
+    private:
+        int socket = -1;
+        pid_t pid = -1;
+        std::mutex mutex;
+
+        struct Reply
+        {
+            pid_t pid;
+            int error;
+            long peak_rss;
+        };
+
+        // The test index is sent with its stdio attached
+        using Descriptors = std::array<int, 3>;
+        using Control = std::array<char, CMSG_SPACE(sizeof(Descriptors))>;
+
+        static inline bool send_request(int socket, std::size_t i,
+                                        Descriptors const& fds)
+        {
+            iovec data = { &i, sizeof(i) };
+            alignas(cmsghdr) Control control{};
+            msghdr message = {};
+            message.msg_iov = &data;
+            message.msg_iovlen = 1;
+            message.msg_control = control.data();
+            message.msg_controllen = control.size();
+            cmsghdr* header = CMSG_FIRSTHDR(&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_RIGHTS;
+            header->cmsg_len = CMSG_LEN(sizeof(Descriptors));
+            std::memcpy(CMSG_DATA(header), fds.data(), sizeof(Descriptors));
+            return sendmsg(socket, &message, MSG_NOSIGNAL) != -1;
+        }
+
+        // Returns false once the runner is gone
+        static inline bool receive_request(int socket, std::size_t& i,
+                                           Descriptors& fds)
+        {
+            iovec data = { &i, sizeof(i) };
+            alignas(cmsghdr) Control control{};
+            msghdr message = {};
+            message.msg_iov = &data;
+            message.msg_iovlen = 1;
+            message.msg_control = control.data();
+            message.msg_controllen = control.size();
+            if (recvmsg(socket, &message, 0) != sizeof(i))
+                return false;
+            cmsghdr* header = CMSG_FIRSTHDR(&message);
+            if (!header || header->cmsg_type != SCM_RIGHTS
+                || header->cmsg_len != CMSG_LEN(sizeof(Descriptors)))
+                return false;
+            std::memcpy(fds.data(), CMSG_DATA(header), sizeof(Descriptors));
+            return true;
+        }
+
+        [[noreturn]] static inline void
+        serve(int socket, EntryPoint entry, char const* program,
+              std::span<StaticProcessData const> tests)
+        {
+            std::size_t i;
+            Descriptors fds;
+            while (receive_request(socket, i, fds))
+            {
+                // fork() cannot give the child to our parent. glibc does not
+                // know about this one, which is fine as long as we hold no
+                // lock.
+                Reply reply = {};
+                reply.pid = static_cast<pid_t>(
+                    syscall(SYS_clone, CLONE_PARENT | SIGCHLD, nullptr,
+                            nullptr, nullptr, nullptr));
+                if (reply.pid == 0)
+                    run_test(socket, entry, program, tests[i], fds);
+                if (reply.pid == -1)
+                    reply.error = errno;
+                rusage usage;
+                if (getrusage(RUSAGE_SELF, &usage) == 0)
+                    reply.peak_rss = usage.ru_maxrss;
+
+                // The test must be the only one left with its pipes open
+                for (int fd : fds)
+                    close(fd);
+                send(socket, &reply, sizeof(reply), MSG_NOSIGNAL);
+            }
+            _exit(0);
+        }
+
+        [[noreturn]] static inline void
+        run_test(int socket, EntryPoint entry, char const* program,
+                 StaticProcessData const& test, Descriptors const& fds)
+        {
+            close(socket);
+            dup2(fds[0], STDIN_FILENO);
+            dup2(fds[1], STDOUT_FILENO);
+            dup2(fds[2], STDERR_FILENO);
+            for (int fd : fds)
+                if (fd > STDERR_FILENO)
+                    close(fd);
+
+            // The runner may have ignored it by now
+            signal(SIGPIPE, SIG_DFL);
+            setpgid(0, 0);
+
+            // argv[0] is the program, then come the arguments of the test
+            std::vector<char*> argv;
+            argv.reserve(test.command_line_argc + 2);
+            argv.push_back(const_cast<char*>(program));
+            for (std::size_t a = 0; a < test.command_line_argc; ++a)
+                argv.push_back(const_cast<char*>(test.command_line_argv[a]));
+            argv.push_back(nullptr);
+
+            int code = entry(static_cast<int>(test.command_line_argc + 1),
+                             argv.data());
+
+            // What a return from main would flush, without running the
+            // destructors of the runner
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+            _exit(code);
+        }
+    };
+
+    // Runs a suite whatever its tests come from. Nothing in here depends on
+    // the tests' types, so it is only compiled once however many suites and
+    // tests there are.
+    class SuiteRunner
+    {
+    public:
+        SuiteRunner(char const* binary_path_,
+                    std::span<StaticProcessData const> metadata_)
+            : binary_path(binary_path_)
+            , metadata(metadata_)
+        {}
+
+        // Tests of a program linked into the runner, called without execv
+        // (see Zygote). Its argv[0] is the one of the runner.
+        SuiteRunner(EntryPoint entry_point_,
+                    std::span<StaticProcessData const> metadata_)
+            : binary_path(program_invocation_name)
+            , entry_point(entry_point_)
+            , metadata(metadata_)
+        {}
+
+    private:
+        // Ran by every test, unless it says otherwise
+        char const* binary_path;
+        // Called instead when set
+        EntryPoint entry_point = nullptr;
+        std::span<StaticProcessData const> metadata;
+
+        // Returns the errno of the fork or of the execv, like posix_spawn
+        static inline int fork_child(int stdin_pipe[2], int stdout_pipe[2],
+                                     int stderr_pipe[2], pid_t& pid,
+                                     char const* path,
+                                     char const* const* argv)
+        {
+            // Closed by a successful execv, written its errno otherwise
+            int exec_pipe[2];
+            if (pipe2(exec_pipe, O_CLOEXEC) == -1)
+                return errno;
+
+            pid = fork();
+            if (pid == -1)
+            {
+                int error = errno;
+                close(exec_pipe[0]);
+                close(exec_pipe[1]);
+                return error;
+            }
+
+            // New process
+            if (pid == 0)
+            {
+                close(exec_pipe[0]);
+                // Link the pipes in the child
+                dup2(stdin_pipe[0], STDIN_FILENO);
+                dup2(stdout_pipe[1], STDOUT_FILENO);
+                dup2(stderr_pipe[1], STDERR_FILENO);
+                close(stdin_pipe[1]);
+                close(stdout_pipe[0]);
+                close(stderr_pipe[0]);
+
+                // The runner ignores it, but ignored signals survive execv
+                signal(SIGPIPE, SIG_DFL);
+                // Own process group, so that a timeout kills the grandchildren
+                // too
+                setpgid(0, 0);
+
+                execv(path, const_cast<char* const*>(argv));
+                int error = errno;
+                [[maybe_unused]] ssize_t sent =
+                    write(exec_pipe[1], &error, sizeof(error));
+                _exit(127);
+            }
+
+            // Also done by the child, whoever comes first avoids the race
+            setpgid(pid, pid);
+
+            close(exec_pipe[1]);
+            int error = 0;
+            ssize_t got;
+            while ((got = read(exec_pipe[0], &error, sizeof(error))) == -1
+                   && errno == EINTR)
+                continue;
+            close(exec_pipe[0]);
+            if (got != sizeof(error))
+                return 0;
+            waitpid(pid, nullptr, 0);
+            return error;
+        }
+
+        // Same as fork_child, without copying our page tables
+        static inline int spawn_child(int stdin_pipe[2], int stdout_pipe[2],
+                                      int stderr_pipe[2], pid_t& pid,
+                                      char const* path,
+                                      char const* const* argv)
+        {
+            // The other ends are close on exec
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_adddup2(&actions, stdin_pipe[0],
+                                             STDIN_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, stdout_pipe[1],
+                                             STDOUT_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, stderr_pipe[1],
+                                             STDERR_FILENO);
+
+            // SIGPIPE back to default, and own process group
+            posix_spawnattr_t attributes;
+            posix_spawnattr_init(&attributes);
+            sigset_t defaulted;
+            sigemptyset(&defaulted);
+            sigaddset(&defaulted, SIGPIPE);
+            posix_spawnattr_setsigdefault(&attributes, &defaulted);
+            posix_spawnattr_setpgroup(&attributes, 0);
+            posix_spawnattr_setflags(&attributes,
+                                     POSIX_SPAWN_SETSIGDEF
+                                         | POSIX_SPAWN_SETPGROUP);
+
+            int error = posix_spawn(&pid, path, &actions, &attributes,
+                                    const_cast<char* const*>(argv), environ);
+
+            posix_spawnattr_destroy(&attributes);
+            posix_spawn_file_actions_destroy(&actions);
+            return error;
+        }
+
+        // Close on exec, so that other tests don't inherit our ends of the
+        // pipes (a sibling holding our stdin open would never let the child
+        // see EOF). A stdin file delivered directly, -1 if there is none,
+        // takes the place of the stdin pipe. Returns 0, or the errno of the
+        // pipe2 that failed, with none of the pipes left open.
+        static inline int open_pipes(int stdin_pipe[2], int stdout_pipe[2],
+                                     int stderr_pipe[2], int stdin_file)
+        {
+            stdin_pipe[0] = stdin_file;
+            stdin_pipe[1] = -1;
+            if (stdin_file == -1 && pipe2(stdin_pipe, O_CLOEXEC) == -1)
+                return errno;
+
+            int error = 0;
+            if (pipe2(stdout_pipe, O_CLOEXEC) == -1)
+                error = errno;
+            else if (pipe2(stderr_pipe, O_CLOEXEC) == -1)
+            {
+                error = errno;
+                close(stdout_pipe[0]);
+                close(stdout_pipe[1]);
+            }
+            if (error != 0 && stdin_file == -1)
+            {
+                close(stdin_pipe[0]);
+                close(stdin_pipe[1]);
+            }
+            return error;
+        }
+
+        // Start a new process on the pipes, through the zygote when there is
+        // one. Returns 0, or the errno of the launch. A stdin file delivered
+        // directly is closed along with the stdin pipe. `rss_floor` is set as
+        // ResourceUsage wants.
+        int setup_process(int stdin_pipe[2], int stdout_pipe[2],
+                          int stderr_pipe[2], pid_t& pid, std::size_t i,
+                          bool blocking_outputs, Zygote* zygote,
+                          long& rss_floor) const
+        {
+            // argv[0] is the binary, then come the arguments of the test
+            auto const& test = metadata[i];
+            char const* path = test.binary ? test.binary : binary_path;
+            std::vector<char const*> argv;
+            argv.reserve(test.command_line_argc + 2);
+            argv.push_back(path);
+            argv.insert(argv.end(), test.command_line_argv,
+                        test.command_line_argv + test.command_line_argc);
+            argv.push_back(nullptr);
+
+            int error;
+            if (zygote && !test.binary)
+                error = zygote->launch(i, stdin_pipe[0], stdout_pipe[1],
+                                       stderr_pipe[1], pid, rss_floor);
+            else
+            {
+                if constexpr (launch_backend == LaunchBackend::PosixSpawn)
+                    error = spawn_child(stdin_pipe, stdout_pipe, stderr_pipe,
+                                        pid, path, argv.data());
+                else
+                    error = fork_child(stdin_pipe, stdout_pipe, stderr_pipe,
+                                       pid, path, argv.data());
+
+                // Our peak only grows, so it is at least the one the child
+                // saw: posix_spawn returns after the execv, and fork copied
+                // no more than what we had then
+                rusage usage;
+                if (getrusage(RUSAGE_SELF, &usage) == 0)
+                    rss_floor = usage.ru_maxrss;
+            }
+
+            // In the parent, close our side of the pipe
+            close(stdin_pipe[0]);
+            close(stdout_pipe[1]);
+            close(stderr_pipe[1]);
+
+            if (error != 0)
+            {
+                if (stdin_pipe[1] != -1)
+                    close(stdin_pipe[1]);
+                close(stdout_pipe[0]);
+                close(stderr_pipe[0]);
+                return error;
+            }
+
+            // The stdin is fed from the event loop as the child drains it, so
+            // that inputs bigger than the pipe capacity cannot block us
+            if (stdin_pipe[1] != -1)
+                fcntl(stdin_pipe[1], F_SETFL, O_NONBLOCK);
+            if (blocking_outputs)
+                return 0;
+            // Make the stdout nonblocking
+            fcntl(stdout_pipe[0], F_SETFL, O_NONBLOCK);
+            // Make the stderr nonblocking
+            fcntl(stderr_pipe[0], F_SETFL, O_NONBLOCK);
+            return 0;
+        }
+
+        static inline void arm_timer(int timer_fd,
+                                     std::chrono::milliseconds delay)
+        {
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+                delay);
+            auto nanoseconds =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(delay
+                                                                     - seconds);
+            itimerspec spec{};
+            spec.it_value.tv_sec = seconds.count();
+            spec.it_value.tv_nsec = nanoseconds.count();
+            timerfd_settime(timer_fd, 0, &spec, nullptr);
+        }
+
+        // Pipe size asked for when splicing a stdin file, the most an
+        // unprivileged process gets by default
+        static constexpr int STDIN_PIPE_SIZE = 1 << 20;
+
+        // A streamed output does not have to be kept whole, the report only
+        // shows its beginning
+        static constexpr std::size_t STREAMED_CAPTURE = 64 << 10;
+
+        static inline std::size_t capture_limit(TestLimits const& limits,
+                                                StreamValidation streamed)
+        {
+            if (streamed && limits.max_capture > STREAMED_CAPTURE)
+                return STREAMED_CAPTURE;
+            return limits.max_capture;
+        }
+
+        // With the exit code of a failed execv in the shells, but an Error
+        // verdict whatever its validators say. Always returns false, for
+        // launch_process.
+        static inline bool fail_launch(RuntimeProcess& proc,
+                                       std::string_view what, int error)
+        {
+            std::string message =
+                std::string(what) + ": " + std::strerror(error) + '\n';
+            proc.stderr_buff.append(message.data(), message.size());
+            proc.status = 127 << 8;
+            proc.exited = true;
+            proc.reaped = true;
+            proc.launch_failed = true;
+            proc.usage.exited = proc.usage.launched;
+            return false;
+        }
+
+        // Fork the i-th test and start listening to its output. Returns false
+        // if the test could not even be started, in which case it is already
+        // complete.
+        bool launch_process(auto& loop, auto& processes, std::size_t i,
+                            Zygote* zygote, RunnerOptions const& options) const
+        {
+            int stdin_pipe[2], stdout_pipe[2], stderr_pipe[2];
+            pid_t pid;
+
+            auto& proc = processes[i];
+            proc.usage.launched = ResourceUsage::Clock::now();
+
+            // Every test gets its own description of the file, and thus its
+            // own offset
+            int stdin_file = -1;
+            if (metadata[i].stdin_file)
+            {
+                stdin_file =
+                    open(metadata[i].stdin_file, O_RDONLY | O_CLOEXEC);
+                if (stdin_file == -1)
+                    return fail_launch(proc, metadata[i].stdin_file, errno);
+            }
+
+            // Whatever can run out is taken before the test starts, rather
+            // than having to kill it
+            proc.timeout_ms = metadata[i].limits.timeout_ms;
+            if (proc.timeout_ms == 0)
+                proc.timeout_ms =
+                    static_cast<std::size_t>(options.default_timeout.count());
+            int timer_fd = -1;
+            if (proc.timeout_ms > 0)
+            {
+                timer_fd = timerfd_create(CLOCK_MONOTONIC,
+                                          TFD_NONBLOCK | TFD_CLOEXEC);
+                if (timer_fd == -1)
+                {
+                    int error = errno;
+                    if (stdin_file != -1)
+                        close(stdin_file);
+                    return fail_launch(proc, "timerfd_create", error);
+                }
+            }
+
+            bool piped_file = stdin_file != -1
+                && metadata[i].limits.stdin_delivery == StdinDelivery::Pipe;
+            int error = open_pipes(stdin_pipe, stdout_pipe, stderr_pipe,
+                                   piped_file ? -1 : stdin_file);
+            if (error != 0)
+            {
+                if (stdin_file != -1)
+                    close(stdin_file);
+                if (timer_fd != -1)
+                    close(timer_fd);
+                return fail_launch(proc, "pipe2", error);
+            }
+
+            error = setup_process(stdin_pipe, stdout_pipe, stderr_pipe, pid, i,
+                                  loop.blocking_outputs, zygote,
+                                  proc.usage.rss_floor);
+            if (error != 0)
+            {
+                if (piped_file)
+                    close(stdin_file);
+                if (timer_fd != -1)
+                    close(timer_fd);
+                if (zygote && !metadata[i].binary)
+                    return fail_launch(proc, "zygote", error);
+                char const* path =
+                    metadata[i].binary ? metadata[i].binary : binary_path;
+                return fail_launch(proc, path, error);
+            }
+
+            loop.watch(stdout_pipe[0], encode_event(i, StreamKind::Stdout));
+            loop.watch(stderr_pipe[0], encode_event(i, StreamKind::Stderr));
+
+            proc.pid = pid;
+            if (stdin_pipe[1] == -1)
+            {
+                // The stdin file was handed over as is
+            }
+            else if (metadata[i].stdinput.empty() && !piped_file)
+            {
+                close(stdin_pipe[1]);
+            }
+            else
+            {
+                // Fewer wakeups to move big files, when we are allowed to
+                if (piped_file)
+                    fcntl(stdin_pipe[1], F_SETPIPE_SZ, STDIN_PIPE_SIZE);
+                loop.watch(stdin_pipe[1], encode_event(i, StreamKind::Stdin));
+                proc.stdin_fd = stdin_pipe[1];
+                proc.stdin_file_fd = stdin_file;
+            }
+            proc.stdout_fd = stdout_pipe[0];
+            proc.stderr_fd = stderr_pipe[0];
+            proc.open_streams = 2;
+            proc.stdout_buff.limit = capture_limit(
+                metadata[i].limits, metadata[i].stdout_stream_validation);
+            proc.stderr_buff.limit = capture_limit(
+                metadata[i].limits, metadata[i].stderr_stream_validation);
+            proc.stdout_cursor.expected = metadata[i].expected_stdout;
+            proc.stderr_cursor.expected = metadata[i].expected_stderr;
+
+            // Exit status comes in asynchronously, like the output
+            proc.pid_fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+            if (proc.pid_fd != -1)
+                loop.watch(proc.pid_fd, encode_event(i, StreamKind::Exit));
+
+            if (timer_fd != -1)
+            {
+                proc.timer_fd = timer_fd;
+                arm_timer(proc.timer_fd,
+                          std::chrono::milliseconds(proc.timeout_ms));
+                loop.watch(proc.timer_fd, encode_event(i, StreamKind::Timer));
+            }
+            return true;
+        }
+
+        // Never signal the group of a reaped child, its id may be reused. An
+        // exited one is still a zombie holding it, and its children may still
+        // be running.
+        static inline void kill_group(RuntimeProcess const& proc, int signal)
+        {
+            if (!proc.reaped)
+                kill(-proc.pid, signal);
+        }
+
+        // Returns true when the stream reached EOF and was closed
+        static inline bool handle_output(auto& loop, IoEvent const& event,
+                                         RuntimeProcess& proc,
+                                         StreamValidation validate)
+        {
+            bool is_stdout = event_kind(event.data) == StreamKind::Stdout;
+            int& fd = is_stdout ? proc.stdout_fd : proc.stderr_fd;
+            auto& output_buff = is_stdout ? proc.stdout_buff : proc.stderr_buff;
+
+            char const* data;
+            ssize_t count = loop.read_output(event, fd, data);
+            if (count < 0)
+                return false;
+
+            std::string_view chunk(data, static_cast<std::size_t>(count));
+            if (count > 0)
+            {
+                if (!proc.usage.first_output)
+                    proc.usage.first_output = ResourceUsage::Clock::now();
+                output_buff.append(chunk.data(), chunk.size());
+            }
 
-                // Stdout
-                if (passed_stdout)
-                {
-                    std::cout << GREEN "  ✔ Stdout is valid\n" RESET;
-                }
+            auto& cursor = is_stdout ? proc.stdout_cursor : proc.stderr_cursor;
+            bool& rejected =
+                is_stdout ? proc.stdout_rejected : proc.stderr_rejected;
+            if (validate && !rejected)
+            {
+                cursor.eof = count == 0;
+                rejected = !validate(chunk, cursor);
+                if (!rejected)
+                    cursor.offset += chunk.size();
                 else
                 {
-                    std::cout << RED "  ✘ Stdout validation failed\n"
-                              << YELLOW "    got stdout:\n"
-                              << "    --------------------\n"
-                              << actual_stdout << '\n'
-                              << "    --------------------\n"
-                              << RESET;
+                    // No need to wait for the rest, the test already failed
+                    proc.killed_on_rejection = !proc.exited;
+                    kill_group(proc, SIGKILL);
+                    if (proc.stdin_fd != -1)
+                        close_input(loop, proc);
                 }
+            }
 
-                // Stderr
-                if (passed_stderr)
-                {
-                    std::cout << GREEN "  ✔ Stderr is valid\n" RESET;
-                }
-                else
-                {
-                    std::cout << RED "  ✘ Stderr validation failed\n"
-                              << YELLOW "    got stderr:\n"
-                              << "    --------------------\n"
-                              << actual_stderr << '\n'
-                              << "    --------------------\n"
-                              << RESET;
-                }
+            if (count == 0)
+            {
+                loop.close_stream(fd);
+                return true;
             }
+            return false;
+        }
 
-            std::cout << std::string(60, '-') << "\n";
+        // Read whatever is left without waiting for EOF, then close. The
+        // io_uring backend reads blocking pipes, which would wait.
+        static inline void drain_output(auto& loop, int& fd, auto& output_buff)
+        {
+            if (loop.blocking_outputs)
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+
+            std::span<char> buffer = loop.scratch_buffer();
+            ssize_t count;
+            while ((count = read(fd, buffer.data(), buffer.size())) > 0)
+                output_buff.append(buffer.data(),
+                                   static_cast<std::size_t>(count));
+            loop.close_stream(fd);
         }
-    } // namespace Output
-    using Output::get_terminal_width;
-    using Output::gradient_bar;
-    using Output::display_result;
 
-    // Not inferable in comptime
-    struct RuntimeProcess
-    {
-        OutputBuffer stdout_buff;
-        OutputBuffer stderr_buff;
+        // A test is over once both its streams hit EOF and the child exited,
+        // in whatever order. Returns true when that just happened.
+        static inline bool try_finish_process(auto& loop, RuntimeProcess& proc)
+        {
+            if (proc.open_streams > 0)
+                return false;
 
-        pid_t pid;
+            // Without pidfd, fall back to blocking on the child
+            if (!proc.exited && proc.pid_fd != -1)
+                return false;
+            if (!proc.reaped)
+            {
+                rusage usage;
+                wait4(proc.pid, &proc.status, 0, &usage);
+                if (!proc.exited)
+                    proc.usage.exited = ResourceUsage::Clock::now();
+                proc.usage.fill(usage);
+                proc.exited = true;
+                proc.reaped = true;
+            }
 
-        int stdout_fd;
-        int stderr_fd;
-    };
+            // The child may have exited without reading everything
+            if (proc.stdin_fd != -1)
+                close_input(loop, proc);
+            if (proc.timer_fd != -1)
+                loop.close_stream(proc.timer_fd);
+            return true;
+        }
 
-    template <char const* BinPath, TestCase Test>
-    struct ArgvBuilder
-    {
-        static constexpr std::array<char const*, Test::command_line_argc + 2>
-            value = []() static consteval {
-                std::array<char const*, Test::command_line_argc + 2> r{};
+        // Left a zombie until try_finish_process reaps it
+        static inline bool handle_exit(auto& loop, RuntimeProcess& proc)
+        {
+            siginfo_t info{};
+            if (waitid(P_PIDFD, static_cast<id_t>(proc.pid_fd), &info,
+                       WEXITED | WNOWAIT | WNOHANG)
+                    == -1
+                || info.si_pid == 0)
+                return false;
 
-                r[0] = BinPath;
-                for (size_t i = 0; i < Test::command_line_argc; ++i)
-                {
-                    r[i + 1] = Test::command_line_argv[i];
-                }
-                r[r.size() - 1] = nullptr;
+            proc.usage.exited = ResourceUsage::Clock::now();
+            proc.exited = true;
+            loop.close_stream(proc.pid_fd);
+            return try_finish_process(loop, proc);
+        }
 
-                return r;
-            }();
-    };
+        // First expiry sends a SIGTERM to the whole process group, the second
+        // one (after the grace period) a SIGKILL. Returns true when the test
+        // is over.
+        static inline bool handle_timeout(auto& loop, RuntimeProcess& proc,
+                                          std::chrono::milliseconds grace)
+        {
+            std::uint64_t expirations;
+            if (read(proc.timer_fd, &expirations, sizeof(expirations)) < 0)
+                return false;
 
-    // Should be all filled at comptime
-    struct StaticProcessData
-    {
-        std::string_view test_name;
-        std::string_view stdinput;
-        bool (*stdout_validation)(std::string_view);
-        bool (*stderr_validation)(std::string_view);
-        bool (*exit_code_validation)(int);
+            if (!proc.timed_out && grace.count() > 0)
+            {
+                proc.timed_out = true;
+                kill_group(proc, SIGTERM);
+                arm_timer(proc.timer_fd, grace);
+                return false;
+            }
 
-        char const* const* command_line_argv;
-        std::size_t command_line_argc;
-    };
+            proc.timed_out = true;
+            kill_group(proc, SIGKILL);
 
-    template <char const* BinaryPath, TestCase... Tests>
-    class TestRunner
-    {
-    private:
-        // Number of tests passed to this template instantiation
-        static constexpr std::size_t NumTests =
-            parameter_pack_size<Tests...>::value;
+            // Something outside of the group may still hold the pipes, we
+            // keep the partial output and stop waiting for EOF
+            if (proc.stdout_fd != -1)
+                drain_output(loop, proc.stdout_fd, proc.stdout_buff);
+            if (proc.stderr_fd != -1)
+                drain_output(loop, proc.stderr_fd, proc.stderr_buff);
+            proc.open_streams = 0;
 
-        // Prefill metadata for the tests in comptime, since these are available
-        static constexpr std::array<StaticProcessData, NumTests> metadata = {
-            { StaticProcessData{ Tests::test_name, Tests::stdinput,
-                                 Tests::validate_stdout, Tests::validate_stderr,
-                                 Tests::validate_exit_code,
-                                 ArgvBuilder<BinaryPath, Tests>::value.data(),
-                                 Tests::command_line_argc }... }
-        };
+            // The timer is one-shot, from now on we only wait for the exit
+            return try_finish_process(loop, proc);
+        }
+
+        static inline void close_input(auto& loop, RuntimeProcess& proc)
+        {
+            loop.close_stream(proc.stdin_fd);
+            if (proc.stdin_file_fd != -1)
+            {
+                close(proc.stdin_file_fd);
+                proc.stdin_file_fd = -1;
+            }
+        }
 
-        // Function to set up pipes and fork a new process
-        static inline void setup_process(int stdin_pipe[2], int stdout_pipe[2],
-                                         int stderr_pipe[2], pid_t& pid,
-                                         std::size_t i)
+        // Write as much of the stdinput as the pipe accepts, and close it once
+        // everything went through or the child stopped reading. A stdin file
+        // goes from the page cache to the pipe without passing through us.
+        static inline void feed_input(auto& loop, RuntimeProcess& proc,
+                                      std::string_view input)
         {
-            pipe(stdin_pipe);
-            pipe(stdout_pipe);
-            pipe(stderr_pipe);
+            bool from_file = proc.stdin_file_fd != -1;
+            ssize_t count;
+            if (from_file)
+                count = splice(proc.stdin_file_fd, nullptr, proc.stdin_fd,
+                               nullptr, STDIN_PIPE_SIZE,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            else
+            {
+                auto left = input.substr(proc.stdin_written);
+                count = write(proc.stdin_fd, left.data(), left.size());
+            }
+            if (count >= 0)
+                proc.stdin_written += static_cast<std::size_t>(count);
+            else if (errno == EAGAIN || errno == EINTR)
+                return;
 
-            pid = fork();
+            // Either fully written, or EPIPE because the child is gone
+            bool done = from_file ? count == 0
+                                  : proc.stdin_written == input.size();
+            if (count < 0 || done)
+                close_input(loop, proc);
+        }
 
-            // New process
-            if (pid == 0)
+        // The fd an event is about, -1 once it was closed
+        static inline int event_fd(RuntimeProcess const& proc, StreamKind kind)
+        {
+            switch (kind)
             {
-                // Link the pipes in the child
-                dup2(stdin_pipe[0], STDIN_FILENO);
-                dup2(stdout_pipe[1], STDOUT_FILENO);
-                dup2(stderr_pipe[1], STDERR_FILENO);
-                close(stdin_pipe[1]);
-                close(stdout_pipe[0]);
-                close(stderr_pipe[0]);
+            case StreamKind::Stdin:
+                return proc.stdin_fd;
+            case StreamKind::Stdout:
+                return proc.stdout_fd;
+            case StreamKind::Stderr:
+                return proc.stderr_fd;
+            case StreamKind::Timer:
+                return proc.timer_fd;
+            case StreamKind::Exit:
+                return proc.pid_fd;
+            default:
+                return -1;
+            }
+        }
 
-                execv(BinaryPath,
-                      const_cast<char* const*>(metadata[i].command_line_argv));
-                perror("execv");
-                _exit(127);
+        bool dispatch_event(auto& loop, RuntimeProcess& proc,
+                            IoEvent const& event,
+                            RunnerOptions const& options) const
+        {
+            std::size_t i = event_process(event.data);
+            StreamKind kind = event_kind(event.data);
+
+            // Any stream might have been closed earlier in the same batch of
+            // events
+            if (event_fd(proc, kind) == -1)
+                return false;
+
+            bool closed = false;
+            switch (kind)
+            {
+            case StreamKind::Stdin:
+                feed_input(loop, proc, metadata[i].stdinput);
+                return false;
+            case StreamKind::Stdout:
+                closed = handle_output(loop, event, proc,
+                                       metadata[i].stdout_stream_validation);
+                break;
+            case StreamKind::Stderr:
+                closed = handle_output(loop, event, proc,
+                                       metadata[i].stderr_stream_validation);
+                break;
+            case StreamKind::Timer:
+                return handle_timeout(loop, proc, options.kill_grace);
+            case StreamKind::Exit:
+                return handle_exit(loop, proc);
+            default:
+                return false;
             }
 
-            // In the parent, close our side of the pipe
-            close(stdin_pipe[0]);
-            close(stdout_pipe[1]);
-            close(stderr_pipe[1]);
-            // Send the stdin data through the pipe
-            write(stdin_pipe[1], metadata[i].stdinput.data(),
-                  metadata[i].stdinput.size());
-            // Close the stdin pipe
-            close(stdin_pipe[1]);
+            if (closed)
+            {
+                --proc.open_streams;
+                return try_finish_process(loop, proc);
+            }
+            return false;
+        }
 
-            // Make the stdout nonblocking
-            fcntl(stdout_pipe[0], F_SETFL, O_NONBLOCK);
-            // Make the stderr nonblocking
-            fcntl(stderr_pipe[0], F_SETFL, O_NONBLOCK);
+        // Returns true when the event completed a test, which frees its slot
+        bool handle_event(auto& loop, auto& processes, IoEvent const& event,
+                          RunnerOptions const& options) const
+        {
+            auto& proc = processes[event_process(event.data)];
+            bool finished = dispatch_event(loop, proc, event, options);
+
+            // Still open, wait for what comes next
+            int fd = event_fd(proc, event_kind(event.data));
+            if (fd != -1)
+                loop.rearm(fd, event.data);
+            return finished;
         }
 
-        static inline void subscribe_to_epoll(int epoll_fd, int pipe[2])
+        // Runs on the validation pool, the test is over and nothing else
+        // touches it
+        static inline void validate_result(StaticProcessData const& test,
+                                           RuntimeProcess& proc)
         {
-            epoll_event ev_out{ .events = EPOLLIN, .data = { .fd = pipe[0] } };
-            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe[0], &ev_out);
+            // Validators are meaningless on a killed process, and there is
+            // nothing to validate for a cached or unlaunched one
+            if (proc.timed_out || proc.cached || proc.launch_failed)
+                return;
+
+            // Unless it exited on its own before the signal got to it, the
+            // exit code of a killed test is not worth validating
+            proc.killed_on_rejection = proc.killed_on_rejection
+                && WIFSIGNALED(proc.status) && WTERMSIG(proc.status) == SIGKILL;
+            proc.passed_exit_code = proc.killed_on_rejection
+                || test.exit_code_validation(decode_exit_code(proc.status));
+            proc.passed_stdout =
+                !overflowed(proc.stdout_buff, test.stdout_stream_validation)
+                && !proc.stdout_rejected
+                && test.stdout_validation(proc.stdout_buff.view());
+            proc.passed_stderr =
+                !overflowed(proc.stderr_buff, test.stderr_stream_validation)
+                && !proc.stderr_rejected
+                && test.stderr_validation(proc.stderr_buff.view());
         }
 
-        static inline void handle_output(auto& buffer, int epoll_fd, int fd,
-                                         auto& output_buff,
-                                         std::size_t& remaining)
+        // Golden files of the running tests, mapped by the first one needing
+        // them and shared with the others until the last one is done. Those
+        // that cannot be opened are not kept, the next test tries again.
+        class GoldenFiles
         {
-            ssize_t count = read(fd, buffer.data(), buffer.size());
-            if (count > 0)
+        public:
+            // Points the cursors of a launched test at its files
+            void open(StaticProcessData const& test, RuntimeProcess& proc)
             {
-                output_buff.append(buffer.data(),
-                                   static_cast<std::size_t>(count));
+                std::lock_guard lock(mutex);
+                attach(test.stdout_file, proc.stdout_cursor);
+                attach(test.stderr_file, proc.stderr_cursor);
             }
-            else if (count == 0)
+
+            // The test is over, unmaps the files it was the last one to use
+            void close(StaticProcessData const& test,
+                       RuntimeProcess const& proc)
             {
-                close(fd);
-                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
-                --remaining;
+                std::lock_guard lock(mutex);
+                detach(test.stdout_file, proc.stdout_cursor);
+                detach(test.stderr_file, proc.stderr_cursor);
             }
-        }
-        static inline void handle_event(int epoll_fd, auto& buffer,
-                                        auto& processes, int fd,
-                                        std::size_t& remaining)
-        {
-            for (auto& proc : processes)
+
+        private:
+            struct Shared
+            {
+                std::unique_ptr<MappedFile> file;
+                std::size_t users = 0;
+            };
+
+            void attach(char const* path, StreamCursor& cursor)
             {
-                if (proc.stdout_fd == fd)
+                if (!path)
+                    return;
+                auto [found, inserted] = files.try_emplace(path);
+                if (inserted)
+                    found->second.file = std::make_unique<MappedFile>(path);
+                if (!*found->second.file)
                 {
-                    handle_output(buffer, epoll_fd, fd, proc.stdout_buff,
-                                  remaining);
+                    files.erase(found);
+                    cursor.unreadable = path;
                     return;
                 }
-                else if (proc.stderr_fd == fd)
-                {
-                    handle_output(buffer, epoll_fd, fd, proc.stderr_buff,
-                                  remaining);
+                ++found->second.users;
+                cursor.expected = found->second.file->view();
+            }
 
+            void detach(char const* path, StreamCursor const& cursor)
+            {
+                if (!path || !cursor.unreadable.empty())
                     return;
+                auto found = files.find(path);
+                if (--found->second.users == 0)
+                    files.erase(found);
+            }
+
+            std::mutex mutex;
+            std::unordered_map<std::string_view, Shared> files;
+        };
+
+        // Shared by the event loops, which take the tests one at a time as
+        // their slots free up. Everything else belongs to a single loop: a
+        // test is only ever touched by the loop that launched it, until it is
+        // handed to the validation pool.
+        struct SharedProgress
+        {
+            // Order in which the tests are launched, an index in it is the
+            // next one to launch
+            std::vector<std::size_t> order;
+            std::atomic<std::size_t> next{ 0 };
+            // Number of tests fully collected
+            std::atomic<std::size_t> done{ 0 };
+            GoldenFiles golden;
+        };
+
+        // Runs tests on `loop`, at most `slots` at a time, until there are
+        // none left to take. `step` is called before every wait, and keeps
+        // the loop waiting with nothing running as long as it returns true.
+        void run_loop(auto& loop, auto& processes, ValidationPool& pool,
+                      SharedProgress& progress, Zygote* zygote,
+                      std::size_t slots, RunnerOptions const& options,
+                      auto&& step) const
+        {
+            std::size_t const num_tests = metadata.size();
+            // Number of tests occupying one of our slots
+            std::size_t running = 0;
+
+            auto fill_slots = [&]() {
+                while (running < slots
+                       && progress.next.load(std::memory_order_relaxed)
+                           < num_tests)
+                {
+                    std::size_t next =
+                        progress.next.fetch_add(1, std::memory_order_relaxed);
+                    if (next >= num_tests)
+                        break;
+                    std::size_t i = progress.order[next];
+                    // Cached tests, like those that cannot be launched, are
+                    // complete right away
+                    if (!processes[i].cached
+                        && launch_process(loop, processes, i, zygote, options))
+                    {
+                        progress.golden.open(metadata[i], processes[i]);
+                        ++running;
+                    }
+                    else
+                    {
+                        progress.done.fetch_add(1, std::memory_order_relaxed);
+                        pool.submit(i);
+                    }
+                }
+            };
+
+            fill_slots();
+            while (step() || running > 0)
+            {
+                loop.wait([&](IoEvent const& event) {
+                    // Picked up by the next step
+                    if (event_kind(event.data) == StreamKind::Validated)
+                    {
+                        pool.acknowledge();
+                        loop.rearm(pool.fd(), event.data);
+                        return;
+                    }
+
+                    if (!handle_event(loop, processes, event, options))
+                        return;
+
+                    std::size_t i = event_process(event.data);
+                    progress.golden.close(metadata[i], processes[i]);
+                    progress.done.fetch_add(1, std::memory_order_relaxed);
+                    --running;
+                    pool.submit(i);
+                });
+
+                // Slots freed up, give them to the next tests
+                fill_slots();
+            }
+        }
+
+        // The loop of the main thread, which also prints the results. It is
+        // the one woken up by the validation pool.
+        void collect_processes(auto& loop, auto& processes,
+                               ValidationPool& pool, SharedProgress& progress,
+                               Zygote* zygote, ProgressBar& bar,
+                               std::vector<ReportSink>& sinks,
+                               std::vector<TestReport>& reports,
+                               std::size_t slots,
+                               RunnerOptions const& options) const
+        {
+            std::size_t const num_tests = metadata.size();
+
+            // Results are printed in declaration order, as soon as all the
+            // ones before them are validated
+            std::vector<bool> validated(num_tests, false);
+
+            auto print_validated = [&]() {
+                pool.drain([&](std::size_t i) { validated[i] = true; });
+
+                std::size_t first = reports.size();
+                while (reports.size() < num_tests && validated[reports.size()])
+                {
+                    std::size_t i = reports.size();
+                    if (i == first)
+                        bar.clear();
+                    if (i == 0 && !options.quiet)
+                        std::cout << std::string(60, '-') << "\n";
+
+                    Verdict verdict =
+                        display_result(metadata, processes, i, options.quiet);
+                    reports.push_back({ metadata[i].test_name, verdict,
+                                        decode_exit_code(processes[i].status),
+                                        processes[i].usage });
+                    for (auto& sink : sinks)
+                        sink.add(reports.back(), processes[i].stdout_buff,
+                                 processes[i].stderr_buff);
+
+                    // Or the RSS of the runner, which the tests launched from
+                    // now on count in theirs, would grow with the suite
+                    processes[i].stdout_buff = OutputBuffer();
+                    processes[i].stderr_buff = OutputBuffer();
                 }
+            };
+
+            auto step = [&]() {
+                print_validated();
+                if (reports.size() == num_tests)
+                    return false;
+                bar.draw(num_tests,
+                         num_tests
+                             - progress.done.load(std::memory_order_relaxed));
+                return true;
+            };
+            run_loop(loop, processes, pool, progress, zygote, slots, options,
+                     step);
+
+            bar.finish(num_tests);
+        }
+
+        std::vector<ReportSink> open_reports(RunnerOptions const& options) const
+        {
+            std::size_t const num_tests = metadata.size();
+            std::vector<ReportSink> sinks;
+            sinks.reserve(2);
+            if (options.junit_report)
+                sinks.emplace_back(options.junit_report, ReportFormat::JUnit,
+                                   binary_path, num_tests,
+                                   options.report_output_limit);
+            if (options.json_lines_report)
+                sinks.emplace_back(options.json_lines_report,
+                                   ReportFormat::JsonLines, binary_path,
+                                   num_tests, options.report_output_limit);
+            return sinks;
+        }
+
+        // Pins the calling thread, and thus the threads and processes it
+        // starts, to a single core until destroyed
+        class CorePinning
+        {
+        public:
+            explicit CorePinning(int cpu)
+            {
+                if (cpu < 0)
+                    return;
+
+                sched_getaffinity(0, sizeof(previous), &previous);
+                cpu_set_t pinned;
+                CPU_ZERO(&pinned);
+                CPU_SET(static_cast<std::size_t>(cpu), &pinned);
+                if (sched_setaffinity(0, sizeof(pinned), &pinned) == -1)
+                    perror("sched_setaffinity");
+                else
+                    active = true;
+            }
+
+            CorePinning(CorePinning const&) = delete;
+            CorePinning& operator=(CorePinning const&) = delete;
+
+            ~CorePinning()
+            {
+                if (active)
+                    sched_setaffinity(0, sizeof(previous), &previous);
             }
+
+        private:
+            cpu_set_t previous;
+            bool active = false;
         };
 
-        static inline void collect_processes(int epoll_fd, auto& processes)
+    public:
+        // Runs the whole suite over and over, so that the runs of a test are
+        // spread over the benchmark instead of back to back. Returns the
+        // reports of the last run, where tests significantly slower than in
+        // the baseline are a Regression.
+        std::vector<TestReport> benchmark(RunnerOptions const& options) const
         {
-            constexpr int MAX_EVENTS = 64;
-            std::array<char, 1024> buffer;
-            std::size_t remaining = NumTests * 2;
+            using Ms = std::chrono::duration<double, std::milli>;
+
+            RunnerOptions round = options;
+            round.quiet = true;
+            round.junit_report = nullptr;
+            round.json_lines_report = nullptr;
+            round.result_cache = nullptr;
+            round.history_file = nullptr;
+            if (options.benchmark_serial)
+                round.max_in_flight = 1;
+
+            std::size_t num_tests = metadata.size();
+            std::vector<std::vector<double>> wall_times(num_tests);
+            std::vector<std::vector<double>> cpu_times(num_tests);
+            std::vector<std::size_t> failed_runs(num_tests, 0);
+
+            std::cout << BOLD << "Benchmarking " << num_tests << " tests, "
+                      << options.benchmark_warmups << " warmup and "
+                      << options.benchmark_runs << " measured runs each"
+                      << RESET << std::endl;
 
-            while (remaining > 0)
+            std::vector<TestReport> reports;
             {
-                gradient_bar(NumTests * 2, remaining - 1);
+                CorePinning pinning(options.benchmark_cpu);
+                std::size_t rounds =
+                    options.benchmark_warmups + options.benchmark_runs;
+                for (std::size_t r = 0; r < rounds; ++r)
+                {
+                    reports = run(round);
+                    if (reports.size() != num_tests)
+                        return reports;
+                    if (r < options.benchmark_warmups)
+                        continue;
+
+                    for (std::size_t i = 0; i < num_tests; ++i)
+                    {
+                        auto const& usage = reports[i].usage;
+                        wall_times[i].push_back(Ms(usage.wall_time()).count());
+                        cpu_times[i].push_back(Ms(usage.cpu_time()).count());
+                        if (reports[i].verdict != Verdict::Pass)
+                            ++failed_runs[i];
+                    }
+                }
+            }
 
-                epoll_event events[MAX_EVENTS];
-                int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+            Baseline baseline;
+            if (options.benchmark_baseline)
+                baseline = Benchmarking::load_baseline(
+                    options.benchmark_baseline);
 
-                for (int i = 0; i < n; ++i)
+            std::vector<BenchmarkResult> results;
+            results.reserve(num_tests);
+            std::size_t slower = 0;
+            std::cout << std::string(60, '-') << "\n";
+            for (std::size_t i = 0; i < num_tests; ++i)
+            {
+                results.push_back(
+                    { metadata[i].test_name,
+                      Benchmarking::distribution(std::move(wall_times[i])),
+                      Benchmarking::distribution(std::move(cpu_times[i])),
+                      failed_runs[i] });
+                if (Benchmarking::display_benchmark(results.back(), baseline)
+                    && reports[i].verdict == Verdict::Pass)
                 {
-                    handle_event(epoll_fd, buffer, processes, events[i].data.fd,
-                                 remaining);
+                    reports[i].verdict = Verdict::Regression;
+                    ++slower;
                 }
             }
+            std::cout << std::string(60, '-') << "\n";
+            if (options.benchmark_baseline)
+                std::cout << BOLD << slower
+                          << " tests significantly slower than the baseline"
+                          << RESET << '\n';
 
-            gradient_bar(NumTests * 2, 0);
-            std::cout << std::endl;
+            if (options.benchmark_save)
+                Benchmarking::save_baseline(options.benchmark_save, results);
+            return reports;
         }
 
-    public:
-        // Main function for the runner
-        static void run_all_tests()
+    private:
+        // Keys of the tests in the result cache, empty for those with a file
+        // that cannot be read. Files shared by several tests, binaries
+        // included, are only hashed once. The validators are compiled into
+        // the runner, and the definition hash cannot tell two lambdas apart,
+        // so the runner's executable is part of every key. Rebuilding it for
+        // whatever reason, changing a single test included, invalidates all
+        // of them: only the tested binaries and files are told apart.
+        std::vector<std::optional<std::uint64_t>> cache_keys() const
         {
-            // Epoll to let us run the tests in parallel while collecting I/O
-            int epoll_fd = epoll_create1(0);
-            if (epoll_fd == -1)
+            using Hash = std::optional<std::uint64_t>;
+            std::vector<Hash> keys(metadata.size());
+            char const* runner_binary = "/proc/self/exe";
+            char const* default_binary =
+                entry_point ? runner_binary : binary_path;
+
+            std::unordered_map<std::string_view, Hash> files;
+            auto file_hash = [&](char const* path) -> Hash {
+                if (!path)
+                    return 0;
+                auto [found, inserted] = files.try_emplace(path);
+                if (inserted)
+                    found->second = Caching::hash_file(path);
+                return found->second;
+            };
+
+            Hash runner = file_hash(runner_binary);
+            if (!runner)
+                return keys;
+
+            for (std::size_t i = 0; i < metadata.size(); ++i)
             {
-                perror("epoll_create1");
-                return;
+                auto const& test = metadata[i];
+                Hash binary =
+                    file_hash(test.binary ? test.binary : default_binary);
+                if (!binary)
+                    continue;
+                std::uint64_t key = Caching::mix(*runner, *binary);
+                key = Caching::mix(key, test.definition_hash);
+                bool readable = true;
+                for (char const* path :
+                     { test.stdin_file, test.stdout_file, test.stderr_file })
+                {
+                    Hash hash = file_hash(path);
+                    readable = readable && hash;
+                    key = Caching::mix(key, hash.value_or(0));
+                }
+                if (readable)
+                    keys[i] = Caching::finalize(key);
             }
+            return keys;
+        }
+
+        // Saves the durations of the tests that ran to completion, and shows
+        // how far the schedule was from the best possible one. Those cut
+        // short by a timeout or a rejected output still held their slot for
+        // as long as they ran, but say nothing about how long they take.
+        void record_history(History& history,
+                            std::vector<RuntimeProcess> const& processes,
+                            std::size_t slots,
+                            RunnerOptions const& options) const
+        {
+            using Ms = std::chrono::duration<double, std::milli>;
 
-            // Start every test in parallel
-            std::array<RuntimeProcess, NumTests> processes;
-            for (std::size_t i = 0; i < NumTests; ++i)
+            std::vector<double> durations;
+            durations.reserve(processes.size());
+            std::optional<ResourceUsage::Clock::time_point> first, last;
+            for (std::size_t i = 0; i < processes.size(); ++i)
             {
-                int stdin_pipe[2], stdout_pipe[2], stderr_pipe[2];
-                pid_t pid;
+                auto const& proc = processes[i];
+                auto const& usage = proc.usage;
+                if (proc.cached || proc.launch_failed)
+                    continue;
+                durations.push_back(Ms(usage.wall_time()).count());
+                if (!proc.timed_out && !proc.killed_on_rejection)
+                    Scheduling::record(history, metadata[i].test_name,
+                                       durations.back());
+                first = std::min(first.value_or(usage.launched),
+                                 usage.launched);
+                last = std::max(last.value_or(usage.exited), usage.exited);
+            }
+            Scheduling::save_history(options.history_file, history);
+
+            if (!options.quiet && first)
+                Scheduling::display_makespan(
+                    Ms(*last - *first).count(),
+                    Scheduling::makespan_lower_bound(durations, slots));
+        }
 
-                setup_process(stdin_pipe, stdout_pipe, stderr_pipe, pid, i);
+        // The whole run, on whichever event loop we got. `make_loop` gives
+        // the other threads their own loop when there are several, a loop
+        // that failed to set up leaves its tests to the others.
+        std::vector<TestReport> run_on(auto& loop, auto&& make_loop,
+                                       Zygote* zygote, std::size_t slots,
+                                       RunnerOptions const& options) const
+        {
+            std::size_t const num_tests = metadata.size();
+            auto start = std::chrono::steady_clock::now();
 
-                subscribe_to_epoll(epoll_fd, stdout_pipe);
-                subscribe_to_epoll(epoll_fd, stderr_pipe);
+            std::vector<RuntimeProcess> processes(num_tests);
 
-                // Fill the runtime struct
-                processes[i] = RuntimeProcess{
-                    {}, {}, pid, stdout_pipe[0], stderr_pipe[0]
-                };
+            std::vector<TestReport> reports;
+            reports.reserve(num_tests);
+
+            // Tests that already passed as they are now are not run again
+            std::optional<ResultCache> cache;
+            std::vector<std::optional<std::uint64_t>> keys;
+            std::size_t cached = 0;
+            if (options.result_cache)
+            {
+                cache.emplace(options.result_cache);
+                keys = cache_keys();
+                for (std::size_t i = 0; i < num_tests; ++i)
+                {
+                    processes[i].cached = keys[i] && cache->passed(*keys[i]);
+                    cached += processes[i].cached;
+                }
+            }
+
+            // Longest tests first, when they cannot all start right away
+            History history;
+            if (options.history_file)
+                history = Scheduling::load_history(options.history_file);
+            SharedProgress progress;
+            if (options.history_file && slots < num_tests)
+                progress.order = Scheduling::longest_first(metadata, history);
+            else
+            {
+                progress.order.resize(num_tests);
+                for (std::size_t i = 0; i < num_tests; ++i)
+                    progress.order[i] = i;
             }
 
-            // Let the process run and collect the output
-            collect_processes(epoll_fd, processes);
+            // A child exiting before reading its whole stdin must not kill us
+            auto previous_sigpipe = signal(SIGPIPE, SIG_IGN);
 
-            std::cout << std::string(60, '-') << "\n";
-            for (std::size_t i = 0; i < NumTests; ++i)
-                display_result(metadata, processes, i);
+            {
+                // Validation of the finished tests overlaps with the ones
+                // still running
+                ValidationPool pool(validation_threads(options),
+                                    validate_result, metadata, processes);
+                if (pool.fd() != -1)
+                    loop.watch(pool.fd(),
+                               encode_event(0, StreamKind::Validated));
+
+                // Let the process run, collect the output and print the
+                // results
+                ProgressBar bar(options.quiet
+                                    ? 0
+                                    : options.progress_redraws_per_second);
+                std::vector<ReportSink> sinks = open_reports(options);
+
+                // Without the pool to wake it up, the main loop would not
+                // hear about the tests completed by the other ones
+                std::size_t loops =
+                    pool.fd() == -1 ? 1 : event_loops(options, slots);
+                std::vector<std::thread> threads;
+                threads.reserve(loops - 1);
+                for (std::size_t l = 1; l < loops; ++l)
+                    threads.emplace_back([&, l]() {
+                        auto own_loop = make_loop(loop_slots(slots, loops, l));
+                        if (own_loop)
+                            run_loop(own_loop, processes, pool, progress,
+                                     zygote, loop_slots(slots, loops, l),
+                                     options, []() { return false; });
+                    });
+
+                collect_processes(loop, processes, pool, progress, zygote, bar,
+                                  sinks, reports, loop_slots(slots, loops, 0),
+                                  options);
+                for (auto& thread : threads)
+                    thread.join();
+
+                if (pool.fd() != -1)
+                    loop.forget(pool.fd());
+            }
+
+            signal(SIGPIPE, previous_sigpipe);
+
+            if (cache)
+            {
+                std::vector<std::string_view> names;
+                names.reserve(num_tests);
+                for (auto const& test : metadata)
+                    names.push_back(test.test_name);
+                cache->update(names, keys, reports);
+                cache->save();
+            }
+
+            auto wall_time = std::chrono::steady_clock::now() - start;
+
+            if (!options.quiet)
+                display_summary(num_tests, cached, slots, wall_time);
+            if (options.history_file)
+                record_history(history, processes, slots, options);
 
             // We are done (Yay \o/)
-            close(epoll_fd);
+            return reports;
+        }
+
+    public:
+        // Main function for the runner, the reports are in declaration order
+        std::vector<TestReport> run(RunnerOptions const& options = {}) const
+        {
+            // At most `slots` tests run at the same time, the next ones are
+            // launched as the running ones finish
+            std::size_t slots = job_slots(options);
+
+            // Before the loops, whose descriptors it would otherwise inherit
+            std::optional<Zygote> zygote;
+            if (entry_point)
+            {
+                zygote.emplace(entry_point, binary_path, metadata);
+                if (!*zygote)
+                    return {};
+            }
+            Zygote* launcher = zygote ? &*zygote : nullptr;
+
+#ifdef TUNCFEST_IO_URING
+            // Container seccomp profiles commonly forbid io_uring
+            UringLoop ring(slots);
+            if (ring)
+                return run_on(
+                    ring,
+                    [](std::size_t count) { return UringLoop(count); },
+                    launcher, slots, options);
+#endif
+
+            // Epoll to let us run the tests in parallel while collecting I/O
+            EpollLoop loop;
+            if (!loop)
+                return {};
+            return run_on(
+                loop, [](std::size_t) { return EpollLoop(); }, launcher, slots,
+                options);
+        }
+    };
+
+    // What a runner can run its tests on: the path of an executable, or the
+    // entry point of a program linked into the runner
+    template <typename T>
+    concept TestTarget =
+        std::same_as<T, char const*> || std::same_as<T, EntryPoint>;
+
+    // Runs the tests listed in its parameters, or every test registered with
+    // REGISTER_TEST in the program when there is none, on Target
+    template <TestTarget auto Target, TestCase... Tests>
+    class TestRunner
+    {
+    private:
+        // Number of tests passed to this template instantiation
+        static constexpr std::size_t NumTests =
+            parameter_pack_size<Tests...>::value;
+
+        // Prefill metadata for the tests in comptime, since these are available
+        static constexpr std::array<StaticProcessData, NumTests> metadata = {
+            { static_process_data<Tests>... }
+        };
+
+        static std::vector<TestReport>
+        run_selected(std::span<StaticProcessData const> tests,
+                     RunnerOptions const& options)
+        {
+            auto execute = [&](SuiteRunner const& runner) {
+                if (options.benchmark_runs > 0)
+                    return runner.benchmark(options);
+                return runner.run(options);
+            };
+
+            bool everything = options.filters.empty()
+                && options.shard_count == 1 && !options.list_tests;
+            if (everything)
+                return execute(SuiteRunner(Target, tests));
+
+            std::vector<StaticProcessData> selected =
+                select_tests(tests, options);
+            if (options.list_tests)
+            {
+                for (auto const& test : selected)
+                    std::cout << test.test_name << '\n';
+                return {};
+            }
+
+            if (!options.quiet)
+            {
+                std::cout << "Selected " << selected.size() << " of "
+                          << tests.size() << " tests";
+                if (options.shard_count > 1)
+                    std::cout << " (shard " << options.shard_index << '/'
+                              << options.shard_count << ')';
+                std::cout << '\n';
+            }
+            return execute(SuiteRunner(Target, selected));
+        }
+
+    public:
+        // Exits with 2 if the shard is not one of 1 to N, as --shard would
+        static std::vector<TestReport>
+        run_all_tests(RunnerOptions const& options = {})
+        {
+            if (options.shard_index == 0
+                || options.shard_index > options.shard_count)
+            {
+                std::cerr << "tuncfest: invalid shard " << options.shard_index
+                          << '/' << options.shard_count
+                          << ", expected I/N with 1 <= I <= N\n";
+                std::exit(2);
+            }
+
+            if constexpr (NumTests == 0)
+            {
+                std::vector<StaticProcessData> registered = registered_tests();
+                return run_selected(registered, options);
+            }
+            else
+                return run_selected(metadata, options);
+        }
+
+        // Same, with the options completed by the command line of the test
+        // binary (see print_usage). Exits with 2 if it is not valid.
+        static std::vector<TestReport>
+        run_all_tests(int argc, char const* const* argv,
+                      RunnerOptions options = {})
+        {
+            if (!parse_arguments(argc, argv, options))
+                std::exit(2);
+            return run_all_tests(options);
         }
     };
 } // namespace Runner
+using Runner::SuiteRunner;
+using Runner::EntryPoint;
 using Runner::TestRunner;
+using Runner::MatrixCase;
+using Runner::TestMatrix;
+using Runner::ZippedTestMatrix;
+using Runner::RunnerOptions;
+using Runner::parse_arguments;
+using Runner::Verdict;
+using Runner::ResourceUsage;
+using Runner::TestReport;